@@ -0,0 +1,409 @@
+/*
+ * Description: B-tree ADT over generic pointers, ordered by a comparison function.
+ * Each node holds up to 2T - 1 keys in a sorted array, so a lookup touches only
+ * log base T of n nodes and scans each one with a binary search.  Deletion follows
+ * the single pass algorithm that tops up a child before descending into it, so no
+ * node ever needs fixing on the way back up.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+#include "btree.h"
+
+#define T 16
+
+/* Node of the tree: a leaf has no children, and an internal node with n keys has
+   n + 1 children, with every key in child[i] between keys[i-1] and keys[i] */
+typedef struct node {
+	int n;
+	bool leaf;
+	void *keys[2*T - 1];
+	struct node *child[2*T];
+} NODE;
+
+struct btree {
+	int count;
+	int (*compare)();
+	NODE *root;
+};
+
+static NODE *createNode(bool leaf);
+static void destroyNode(NODE *np);
+static int position(BTREE *tp, NODE *np, void *key);
+static void splitChild(NODE *np, int i);
+static void insertNonFull(BTREE *tp, NODE *np, void *key);
+static void deleteKey(BTREE *tp, NODE *np, void *key);
+static void fillChild(NODE *np, int i);
+static void mergeChildren(NODE *np, int i);
+static bool walkNode(BTREE *tp, NODE *np, void *low, void *high, void (*visit)(), void *arg);
+static int copyKeys(NODE *np, void *keys[], int k);
+
+
+/*
+ * Time Complexity: O(1)
+ * Description: Creates an empty tree ordered by compare
+ */
+BTREE *createTree(int (*compare)()) {
+	assert(compare!=NULL);
+	BTREE *tp = malloc(sizeof(BTREE));
+	assert(tp!=NULL);
+	tp->count = 0;
+	tp->compare = compare;
+	tp->root = createNode(true);
+	return tp;
+}
+
+
+/*
+ * Time Complexity: O(n)
+ * Description: Frees all memory associated with BTREE tp, but not the keys
+ */
+void destroyTree(BTREE *tp) {
+	assert(tp!=NULL);
+	destroyNode(tp->root);
+	free(tp);
+}
+
+
+/*
+ * Time Complexity: O(1)
+ * Description: Returns the number of keys in BTREE tp
+ */
+int numKeys(BTREE *tp) {
+	assert(tp!=NULL);
+	return tp->count;
+}
+
+
+/*
+ * Time Complexity: O(log n)
+ * Description: Adds key to BTREE tp, which must not already hold an equal key.  A
+ * full root is split first, so the tree only ever grows at the top
+ */
+void addKey(BTREE *tp, void *key) {
+	assert(tp!=NULL && key!=NULL);
+	NODE *root = tp->root;
+	if(root->n == 2*T - 1) {
+		tp->root = createNode(false);
+		tp->root->child[0] = root;
+		splitChild(tp->root, 0);
+	}
+	insertNonFull(tp, tp->root, key);
+	tp->count++;
+}
+
+
+/*
+ * Time Complexity: O(log n)
+ * Description: Removes the key equal to key from BTREE tp, if there is one
+ */
+void removeKey(BTREE *tp, void *key) {
+	assert(tp!=NULL && key!=NULL);
+	NODE *root = tp->root;
+	deleteKey(tp, root, key);
+	if(root->n == 0 && !root->leaf) {  /* the root's last two children were merged */
+		tp->root = root->child[0];
+		free(root);
+	}
+}
+
+
+/*
+ * Time Complexity: O(log n)
+ * Description: Returns the smallest key of BTREE tp that is not less than key, or
+ * NULL if there is none
+ */
+void *getLowerBound(BTREE *tp, void *key) {
+	assert(tp!=NULL && key!=NULL);
+	NODE *np = tp->root;
+	void *bound = NULL;
+	int i;
+	while(np != NULL) {
+		i = position(tp, np, key);
+		if(i < np->n) {
+			if((*tp->compare)(np->keys[i], key) == 0)
+				return np->keys[i];
+			bound = np->keys[i];  /* every key still to be seen is less than this one */
+		}
+		np = np->leaf ? NULL : np->child[i];
+	}
+	return bound;
+}
+
+
+/*
+ * Time Complexity: O(log n + m) for m keys visited
+ * Description: Calls visit(key, arg) in order on every key of BTREE tp that is not
+ * less than low and is less than high.  Either bound may be NULL to leave that end
+ * of the range open
+ */
+void walkKeys(BTREE *tp, void *low, void *high, void (*visit)(), void *arg) {
+	assert(tp!=NULL && visit!=NULL);
+	walkNode(tp, tp->root, low, high, visit, arg);
+}
+
+
+/*
+ * Time Complexity: O(n)
+ * Description: Stores every key of BTREE tp in order in keys, which must have room
+ * for all of them
+ */
+void getKeys(BTREE *tp, void *keys[]) {
+	assert(tp!=NULL && (keys!=NULL || tp->count == 0));
+	copyKeys(tp->root, keys, 0);
+}
+
+
+/*
+ * Time Complexity: O(1)
+ * Description: Returns a new node with no keys
+ */
+static NODE *createNode(bool leaf) {
+	NODE *np = malloc(sizeof(NODE));
+	assert(np!=NULL);
+	np->n = 0;
+	np->leaf = leaf;
+	return np;
+}
+
+
+/*
+ * Time Complexity: O(n)
+ * Description: Frees node np and everything below it
+ */
+static void destroyNode(NODE *np) {
+	int i;
+	if(!np->leaf) {
+		for(i = 0; i <= np->n; i++)
+			destroyNode(np->child[i]);
+	}
+	free(np);
+}
+
+
+/*
+ * Time Complexity: O(log T)
+ * Description: Returns the index of the first key of node np that is not less than
+ * key, or the number of keys if there is none
+ */
+static int position(BTREE *tp, NODE *np, void *key) {
+	int low = 0;
+	int high = np->n;
+	int mid;
+	while(low < high) {
+		mid = (low + high)/2;
+		if((*tp->compare)(np->keys[mid], key) < 0)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return low;
+}
+
+
+/*
+ * Time Complexity: O(T)
+ * Description: Splits the full ith child of node np in two around its middle key,
+ * which moves up into np
+ */
+static void splitChild(NODE *np, int i) {
+	NODE *left = np->child[i];
+	NODE *right = createNode(left->leaf);
+	int j;
+	right->n = T - 1;
+	for(j = 0; j < T - 1; j++)
+		right->keys[j] = left->keys[j + T];
+	if(!left->leaf) {
+		for(j = 0; j < T; j++)
+			right->child[j] = left->child[j + T];
+	}
+	left->n = T - 1;
+	for(j = np->n; j > i; j--)
+		np->child[j + 1] = np->child[j];
+	np->child[i + 1] = right;
+	for(j = np->n - 1; j >= i; j--)
+		np->keys[j + 1] = np->keys[j];
+	np->keys[i] = left->keys[T - 1];
+	np->n++;
+}
+
+
+/*
+ * Time Complexity: O(T log n)
+ * Description: Adds key below node np, which is not full, splitting any full child
+ * before descending into it
+ */
+static void insertNonFull(BTREE *tp, NODE *np, void *key) {
+	int i, j;
+	while(!np->leaf) {
+		i = position(tp, np, key);
+		if(np->child[i]->n == 2*T - 1) {
+			splitChild(np, i);
+			if((*tp->compare)(np->keys[i], key) < 0)
+				i++;
+		}
+		np = np->child[i];
+	}
+	i = position(tp, np, key);
+	for(j = np->n; j > i; j--)
+		np->keys[j] = np->keys[j - 1];
+	np->keys[i] = key;
+	np->n++;
+}
+
+
+/*
+ * Time Complexity: O(T log n)
+ * Description: Removes the key equal to key from below node np, which has at least
+ * T keys unless it is the root
+ */
+static void deleteKey(BTREE *tp, NODE *np, void *key) {
+	NODE *cp;
+	int i, j;
+	i = position(tp, np, key);
+	if(i < np->n && (*tp->compare)(np->keys[i], key) == 0) {
+		if(np->leaf) {
+			for(j = i; j < np->n - 1; j++)
+				np->keys[j] = np->keys[j + 1];
+			np->n--;
+			tp->count--;
+		}
+		else if(np->child[i]->n >= T) {  /* replace the key with its predecessor */
+			for(cp = np->child[i]; !cp->leaf; cp = cp->child[cp->n])
+				;
+			np->keys[i] = cp->keys[cp->n - 1];
+			deleteKey(tp, np->child[i], np->keys[i]);
+		}
+		else if(np->child[i + 1]->n >= T) {  /* or with its successor */
+			for(cp = np->child[i + 1]; !cp->leaf; cp = cp->child[0])
+				;
+			np->keys[i] = cp->keys[0];
+			deleteKey(tp, np->child[i + 1], np->keys[i]);
+		}
+		else {
+			mergeChildren(np, i);
+			deleteKey(tp, np->child[i], key);
+		}
+	}
+	else if(!np->leaf) {
+		if(np->child[i]->n < T) {
+			fillChild(np, i);
+			if(i > np->n)  /* the last child was merged into the one before it */
+				i--;
+		}
+		deleteKey(tp, np->child[i], key);
+	}
+}
+
+
+/*
+ * Time Complexity: O(T)
+ * Description: Gives the ith child of node np, which has T - 1 keys, another key by
+ * borrowing one through np from a sibling with keys to spare, or else by merging
+ * it with a sibling
+ */
+static void fillChild(NODE *np, int i) {
+	NODE *cp = np->child[i];
+	NODE *sp;
+	int j;
+	if(i > 0 && np->child[i - 1]->n >= T) {
+		sp = np->child[i - 1];
+		for(j = cp->n; j > 0; j--)
+			cp->keys[j] = cp->keys[j - 1];
+		if(!cp->leaf) {
+			for(j = cp->n + 1; j > 0; j--)
+				cp->child[j] = cp->child[j - 1];
+			cp->child[0] = sp->child[sp->n];
+		}
+		cp->keys[0] = np->keys[i - 1];
+		np->keys[i - 1] = sp->keys[sp->n - 1];
+		cp->n++;
+		sp->n--;
+	}
+	else if(i < np->n && np->child[i + 1]->n >= T) {
+		sp = np->child[i + 1];
+		cp->keys[cp->n] = np->keys[i];
+		if(!cp->leaf)
+			cp->child[cp->n + 1] = sp->child[0];
+		np->keys[i] = sp->keys[0];
+		for(j = 0; j < sp->n - 1; j++)
+			sp->keys[j] = sp->keys[j + 1];
+		if(!sp->leaf) {
+			for(j = 0; j < sp->n; j++)
+				sp->child[j] = sp->child[j + 1];
+		}
+		cp->n++;
+		sp->n--;
+	}
+	else if(i < np->n)
+		mergeChildren(np, i);
+	else
+		mergeChildren(np, i - 1);
+}
+
+
+/*
+ * Time Complexity: O(T)
+ * Description: Merges the ith and i+1th children of node np, which have T - 1 keys
+ * each, around the ith key of np, which moves down between them
+ */
+static void mergeChildren(NODE *np, int i) {
+	NODE *left = np->child[i];
+	NODE *right = np->child[i + 1];
+	int j;
+	left->keys[T - 1] = np->keys[i];
+	for(j = 0; j < right->n; j++)
+		left->keys[j + T] = right->keys[j];
+	if(!left->leaf) {
+		for(j = 0; j <= right->n; j++)
+			left->child[j + T] = right->child[j];
+	}
+	left->n += right->n + 1;
+	for(j = i; j < np->n - 1; j++)
+		np->keys[j] = np->keys[j + 1];
+	for(j = i + 1; j < np->n; j++)
+		np->child[j] = np->child[j + 1];
+	np->n--;
+	free(right);
+}
+
+
+/*
+ * Time Complexity: O(log n + m) for m keys visited
+ * Description: Visits in order the keys below node np from low up to but not
+ * including high, skipping the subtrees that hold only smaller keys.  Returns false
+ * once a key at or past high has been seen, so the caller can stop as well
+ */
+static bool walkNode(BTREE *tp, NODE *np, void *low, void *high, void (*visit)(), void *arg) {
+	int i = (low != NULL) ? position(tp, np, low) : 0;
+	for(; i <= np->n; i++) {
+		if(!np->leaf && !walkNode(tp, np->child[i], low, high, visit, arg))
+			return false;
+		if(i == np->n)
+			break;
+		if(high != NULL && (*tp->compare)(np->keys[i], high) >= 0)
+			return false;
+		(*visit)(np->keys[i], arg);
+	}
+	return true;
+}
+
+
+/*
+ * Time Complexity: O(n)
+ * Description: Stores the keys below node np in order in keys starting at index k,
+ * returning the index after the last one
+ */
+static int copyKeys(NODE *np, void *keys[], int k) {
+	int i;
+	for(i = 0; i < np->n; i++) {
+		if(!np->leaf)
+			k = copyKeys(np->child[i], keys, k);
+		keys[k++] = np->keys[i];
+	}
+	if(!np->leaf)
+		k = copyKeys(np->child[np->n], keys, k);
+	return k;
+}
@@ -3,69 +3,296 @@
  *
  * Copyright:	2017, Darren C. Atkinson
  *
- * Description: This file contains the main function for testing a set
- *              abstract data type for strings.
+ * Description: This file contains the main function for testing a map
+ *              abstract data type from strings to counts.
  *
  *              The program takes one file as a command line argument and
  *              counts the number of times each word appears in the file.
+ *              With -k, only the k most frequent words are printed, most
+ *              frequent first, by passing the counts through a min-heap
+ *              that never holds more than k entries.
+ *
+ *              With -a, the counts are instead estimated in fixed memory
+ *              by a count-min sketch of -w counters by -d rows, and exact
+ *              counts are kept only for a small table of candidates for
+ *              the top k, which defaults to 100.  The error bound of the
+ *              sketch is reported on the standard error.
  */
 
 # include <stdio.h>
 # include <stdlib.h>
 # include <string.h>
-# include <assert.h>
-# include "set.h"
+# include <stdbool.h>
+# include <limits.h>
+# include <math.h>
+# include "map.h"
+# include "pqueue.h"
+# include "sketch.h"
+# include "token.h"
+
+
+/* This is only a starting size, since the map grows as needed. */
+
+# define MAX_SIZE 18000
+
+
+/* Defaults for approximate counting, and how many candidates are kept per word
+   reported. */
+
+# define WIDTH 65536
+# define DEPTH 4
+# define TOP 100
+# define CANDIDATES 2
 
 struct entry {
     char *word;
-    int count;
+    long count;
 };
 
+struct top {
+    PQ *pq;
+    int k;
+    struct entry *entries;
+    struct entry *spare;
+    struct entry floor;
+};
 
-/* This is sufficient for the test cases in /scratch/coen12. */
 
-# define MAX_SIZE 18000
+/*
+ * Function:	printPair
+ *
+ * Description:	Print a word and its count.
+ */
+
+static void printPair(char *word, long count, void *arg)
+{
+    printf("%s: %ld\n", word, count);
+}
 
 
 /*
- * Function:    strhash
+ * Function:	addPair
  *
- * Description: Return a hash value for a string S.
+ * Description:	Append a word and its count to the array of entries that
+ *		arg points into, advancing the pointer past it.
  */
 
-static unsigned strhash(char *s)
+static void addPair(char *word, long count, void *arg)
 {
-    unsigned hash = 0;
+    struct entry **epp = arg;
 
 
-    while (*s != '\0')
-        hash = 31 * hash + *s ++;
+    (*epp)->word = word;
+    (*epp)->count = count;
+    (*epp) ++;
+}
 
-    return hash;
+
+/*
+ * Function:	compareWords
+ *
+ * Description:	Compare two entries by their words as in strcmp(), for
+ *		qsort().
+ */
+
+static int compareWords(const void *p1, const void *p2)
+{
+    return strcmp(((struct entry *) p1)->word, ((struct entry *) p2)->word);
 }
 
 
 /*
- * Function:	hashEntry
+ * Function:	printSorted
  *
- * Description:	Return a hash value for an entry based on its word.
+ * Description:	Print every word of a map and its count, in order of the
+ *		words.
  */
 
-static unsigned hashEntry(struct entry *ep)
+static void printSorted(MAP *counts, char *program)
 {
-    return strhash(ep->word);
+    struct entry *entries, *next;
+    int i;
+
+
+    entries = malloc(sizeof(struct entry) * (numPairs(counts) + 1));
+
+    if (entries == NULL) {
+	fprintf(stderr, "%s: out of memory\n", program);
+	exit(EXIT_FAILURE);
+    }
+
+    next = entries;
+    forEachPair(counts, addPair, &next);
+    qsort(entries, numPairs(counts), sizeof(struct entry), compareWords);
+
+    for (i = 0; i < numPairs(counts); i ++)
+	printPair(entries[i].word, entries[i].count, NULL);
+
+    free(entries);
 }
 
 
 /*
  * Function:	compareEntries
  *
- * Description:	Compare two entries as in strcmp().
+ * Description:	Compare two entries so that the less frequent one comes
+ *		first, and of two equally frequent ones the one whose word
+ *		is greater as in strcmp(), so every word has a fixed rank.
  */
 
 static int compareEntries(struct entry *ep1, struct entry *ep2)
 {
-    return strcmp(ep1->word, ep2->word);
+    if (ep1->count != ep2->count)
+	return ep1->count < ep2->count ? -1 : 1;
+
+    return strcmp(ep2->word, ep1->word);
+}
+
+
+/*
+ * Function:	offerPair
+ *
+ * Description:	Offer a word and its count to the top k.  Until the heap
+ *		is full every word goes in; after that a word is pushed and
+ *		the least entry popped, and the popped entry becomes the
+ *		floor, since no word ranked at or below it can reach the top
+ *		k.  The popped entry's storage holds the next word offered.
+ */
+
+static void offerPair(char *word, long count, void *arg)
+{
+    struct top *tp = arg;
+    struct entry *ep;
+
+
+    if (numEntries(tp->pq) < tp->k) {
+	ep = &tp->entries[numEntries(tp->pq)];
+	ep->word = word;
+	ep->count = count;
+	addEntry(tp->pq, ep);
+	return;
+    }
+
+    tp->spare->word = word;
+    tp->spare->count = count;
+
+    if (compareEntries(tp->spare, &tp->floor) <= 0)
+	return;
+
+    addEntry(tp->pq, tp->spare);
+    tp->spare = removeEntry(tp->pq);
+    tp->floor = *tp->spare;
+}
+
+
+/*
+ * Function:	printTop
+ *
+ * Description:	Print the k most frequent words of a map, most frequent
+ *		first, in O(n log k) time and O(k) space.
+ */
+
+static void printTop(MAP *counts, int k)
+{
+    struct top t;
+    struct entry **sorted;
+    int i, n;
+
+
+    t.pq = createQueue(compareEntries);
+    t.k = k;
+    t.entries = malloc(sizeof(struct entry) * (k + 1));
+    t.spare = &t.entries[k];
+    t.floor.word = "";
+    t.floor.count = LONG_MIN;
+    sorted = malloc(sizeof(struct entry *) * k);
+
+    if (t.entries == NULL || sorted == NULL) {
+	fprintf(stderr, "counts: out of memory\n");
+	exit(EXIT_FAILURE);
+    }
+
+    forEachPair(counts, offerPair, &t);
+
+
+    /* The heap gives the entries least first, so fill the array from the end. */
+
+    n = numEntries(t.pq);
+
+    for (i = n - 1; i >= 0; i --)
+	sorted[i] = removeEntry(t.pq);
+
+    for (i = 0; i < n; i ++)
+	printPair(sorted[i]->word, sorted[i]->count, NULL);
+
+    destroyQueue(t.pq);
+    free(t.entries);
+    free(sorted);
+}
+
+
+/*
+ * Function:	findLeast
+ *
+ * Description:	Remember a word and its count if the count is the least
+ *		seen so far.
+ */
+
+static void findLeast(char *word, long count, void *arg)
+{
+    struct entry *ep = arg;
+
+
+    if (count < ep->count) {
+	ep->word = word;
+	ep->count = count;
+    }
+}
+
+
+/*
+ * Function:	countApprox
+ *
+ * Description:	Count every word read in a sketch, and return a map of at
+ *		most limit candidates for the most frequent words.  A word
+ *		enters the map with its estimate once that is above the
+ *		least count in the map, which it evicts, and is counted
+ *		exactly from then on.  Candidate counts only grow, so the
+ *		least count found by the last scan of the map is a floor
+ *		below which no word needs a scan.
+ */
+
+static MAP *countApprox(TOKENS *tp, SKETCH *sk, int limit)
+{
+    MAP *candidates;
+    struct entry least;
+    long *vp, estimate, floor = 0;
+    char *word;
+    int length;
+
+
+    candidates = createMap(limit);
+
+    while (nextToken(tp, &word, &length)) {
+	estimate = addCount(sk, word, length, 1);
+
+	if ((vp = findValue(candidates, word, length)) != NULL)
+	    (*vp) ++;
+	else if (numPairs(candidates) < limit)
+	    setValue(candidates, word, length, estimate);
+	else if (estimate > floor) {
+	    least.count = LONG_MAX;
+	    forEachPair(candidates, findLeast, &least);
+	    floor = least.count;
+
+	    if (estimate > least.count) {
+		removePair(candidates, least.word, strlen(least.word));
+		setValue(candidates, word, length, estimate);
+	    }
+	}
+    }
+
+    return candidates;
 }
 
 
@@ -77,61 +304,79 @@ static int compareEntries(struct entry *ep1, struct entry *ep2)
 
 int main(int argc, char *argv[])
 {
-    FILE *fp;
-    char buffer[BUFSIZ];
-    struct entry e, *ep, **entries;
-    SET *counts;
-    int i;
+    TOKENS *tp;
+    SKETCH *sk;
+    char *word, *name = argv[0];
+    int length, k = 0, width = WIDTH, depth = DEPTH;
+    bool aflag = false;
+    MAP *counts;
 
 
     /* Check usage and open the file. */
 
-    if (argc != 2) {
-        fprintf(stderr, "usage: %s file\n", argv[0]);
+    while (argc > 2 && argv[1][0] == '-') {
+	if (strcmp(argv[1], "-a") == 0)
+	    aflag = true;
+	else if (strcmp(argv[1], "-k") == 0 && argc > 3)
+	    k = atoi(argv[2]), argc --, argv ++;
+	else if (strcmp(argv[1], "-w") == 0 && argc > 3)
+	    width = atoi(argv[2]), argc --, argv ++;
+	else if (strcmp(argv[1], "-d") == 0 && argc > 3)
+	    depth = atoi(argv[2]), argc --, argv ++;
+	else
+	    break;
+
+	argc --, argv ++;
+    }
+
+    if (argc != 2 || k < 0 || width < 1 || depth < 1 || depth > 32) {
+        fprintf(stderr, "usage: %s [-a] [-k count] [-w width] [-d depth] file\n", name);
         exit(EXIT_FAILURE);
     }
 
-    if ((fp = fopen(argv[1], "r")) == NULL) {
+    argv[0] = name;
+
+    if ((tp = openTokens(argv[1])) == NULL) {
         fprintf(stderr, "%s: cannot open %s\n", argv[0], argv[1]);
         exit(EXIT_FAILURE);
     }
 
 
-    /* Increment the count on each word read. */
+    /* Estimate the counts in a sketch if desired and print the top words. */
 
-    counts = createSet(MAX_SIZE, compareEntries, hashEntry);
+    if (aflag) {
+	sk = createSketch(width, depth);
+	counts = countApprox(tp, sk, CANDIDATES * (k > 0 ? k : TOP));
+	closeTokens(tp);
 
-    while (fscanf(fp, "%s", buffer) == 1) {
-	e.word = buffer;
-	ep = findElement(counts, &e);
+	printTop(counts, k > 0 ? k : TOP);
+	fprintf(stderr, "%s: %d x %d sketch, counts overestimated by at most %.0f"
+	    " with probability %g\n", name, width, depth,
+	    ceil(M_E / width * totalCount(sk)), 1 - exp(-depth));
 
-	if (ep == NULL) {
-	    ep = malloc(sizeof(struct entry));
-	    assert(ep != NULL);
+	destroySketch(sk);
+	destroyMap(counts);
+	exit(EXIT_SUCCESS);
+    }
 
-	    ep->word = strdup(buffer);
-	    assert(ep->word != NULL);
 
-	    ep->count = 1;
-	    addElement(counts, ep);
+    /* Increment the count on each word read. */
 
-	} else
-	    ep->count ++;
-    }
+    counts = createMap(MAX_SIZE);
 
+    while (nextToken(tp, &word, &length))
+	increment(counts, word, length, 1);
 
-    /* Print out the counts for each word. */
+    closeTokens(tp);
 
-    entries = getElements(counts);
 
-    for (i = 0; i < numElements(counts); i ++) {
-	printf("%s: %d\n", entries[i]->word, entries[i]->count);
-	free(entries[i]->word);
-	free(entries[i]);
-    }
+    /* Print out the counts for each word. */
 
-    free(entries);
+    if (k > 0)
+	printTop(counts, k);
+    else
+	printSorted(counts, argv[0]);
 
-    destroySet(counts);
+    destroyMap(counts);
     exit(EXIT_SUCCESS);
 }
@@ -0,0 +1,395 @@
+/*
+ * Description: Map ADT from strings to long values.  Every slot of the open addressed
+ * table holds its pair's value next to the key's cached hash and length, so updating
+ * a count costs one probe sequence and touches a single cache line unless the hashes
+ * of two keys collide.  Keys are copied into large blocks instead of being allocated
+ * one at a time.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+#include <limits.h>
+#include "map.h"
+#include "hash.h"
+
+#define MIN_LENGTH 8
+#define BLOCK_SIZE 65536
+
+/* Each slot holds a key with its full hash and length, and its value; key is NULL if empty */
+typedef struct slot {
+	char *key;
+	unsigned hash;
+	int length;
+	long value;
+} SLOT;
+
+/* Keys are bump allocated out of a list of large blocks */
+typedef struct block {
+	struct block *next;
+	int used;
+	int size;
+	char text[];
+} BLOCK;
+
+/* Home slot of a hash, taken from its top bits */
+#define home(mp, hash) ((hash) >> (mp)->shift)
+
+/* Distance of the pair in slot i from its home slot */
+#define distance(mp, i) (((i) - home(mp, (mp)->slots[i].hash)) & ((mp)->length - 1))
+
+static int search(MAP *mp, char *key, unsigned hash, int length, bool *found, int *dist);
+static void insert(MAP *mp, int index, int dist, SLOT slot);
+static void add(MAP *mp, char *key, SLOT slot, int index, int dist);
+static void erase(MAP *mp, int index);
+static int tableLength(int n);
+static int tableShift(int length);
+static void rehash(MAP *mp, int length);
+static char *allocate(MAP *mp, char *s, int length);
+static void compact(MAP *mp);
+
+/* live and dead count the bytes of block space held by present and removed keys */
+struct map {
+	SLOT *slots;
+	int count;
+	int length;
+	int shift;
+	BLOCK *blocks;
+	long live;
+	long dead;
+};
+
+
+/*
+ * Time Complexity: O(n)
+ * Description: Creates a new map, maxElts is only a hint since the table grows as needed
+ */
+MAP *createMap(int maxElts) {
+	MAP *mp = malloc(sizeof(MAP));
+	assert(mp!=NULL);
+	mp->length = tableLength(maxElts);
+	mp->shift = tableShift(mp->length);
+	mp->count = 0;
+	mp->blocks = NULL;
+	mp->live = 0;
+	mp->dead = 0;
+	mp->slots = malloc(sizeof(SLOT)*mp->length);
+	assert(mp->slots!=NULL);
+	int i;
+	for(i = 0; i < mp->length; i++)
+		mp->slots[i].key = NULL;
+	return mp;
+}
+
+
+/*
+ *  Time Complexity: O(1) per block
+ *  Description: Frees all memory associated with MAP mp
+ */
+void destroyMap(MAP *mp) {
+	assert(mp!=NULL);
+	BLOCK *bp;
+	while(mp->blocks != NULL) {
+		bp = mp->blocks;
+		mp->blocks = bp->next;
+		free(bp);
+	}
+	free(mp->slots);
+	free(mp);
+}
+
+
+/*
+ *  Time Complexity: O(1)
+ *  Description: Returns the number of keys in MAP mp
+ */
+int numPairs(MAP *mp) {
+	assert(mp!=NULL);
+	return mp->count;
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1) amortized]
+ *  Description: Adds delta to the value of the length bytes at key in MAP mp, first
+ *  adding the key with a value of zero if it is not there, and returns the new value
+ */
+long increment(MAP *mp, char *key, int length, long delta) {
+	assert((mp!=NULL) && (key!=NULL) && (length >= 0));
+	bool found;
+	int dist;
+	SLOT slot;
+	slot.length = length;
+	slot.hash = hashBytes(key, length);
+	int index = search(mp, key, slot.hash, length, &found, &dist);
+	if(found)
+		return mp->slots[index].value += delta;
+	slot.value = delta;
+	add(mp, key, slot, index, dist);
+	return delta;
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1) amortized]
+ *  Description: Sets the value of the length bytes at key in MAP mp, adding the key
+ *  if it is not there
+ */
+void setValue(MAP *mp, char *key, int length, long value) {
+	assert((mp!=NULL) && (key!=NULL) && (length >= 0));
+	bool found;
+	int dist;
+	SLOT slot;
+	slot.length = length;
+	slot.hash = hashBytes(key, length);
+	int index = search(mp, key, slot.hash, length, &found, &dist);
+	if(found)
+		mp->slots[index].value = value;
+	else {
+		slot.value = value;
+		add(mp, key, slot, index, dist);
+	}
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1)]
+ *  Description: Returns the location of the value of the length bytes at key in MAP
+ *  mp, or NULL if the key is not there.  The location stays valid only until the
+ *  next key is added or removed
+ */
+long *findValue(MAP *mp, char *key, int length) {
+	assert((mp!=NULL) && (key!=NULL) && (length >= 0));
+	bool found;
+	int dist;
+	int index = search(mp, key, hashBytes(key, length), length, &found, &dist);
+	if(found)
+		return &mp->slots[index].value;
+	return NULL;
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1) amortized]
+ *  Description: Removes the length bytes at key and their value from MAP mp
+ */
+void removePair(MAP *mp, char *key, int length) {
+	assert((mp!=NULL) && (key!=NULL) && (length >= 0));
+	bool found;
+	int dist;
+	int index = search(mp, key, hashBytes(key, length), length, &found, &dist);
+	if(found)
+		erase(mp, index);
+}
+
+
+/*
+ *  Time Complexity: O(n)
+ *  Description: Calls visit on every key of MAP mp with its value, passing arg along
+ */
+void forEachPair(MAP *mp, void (*visit)(char *key, long value, void *arg), void *arg) {
+	assert((mp!=NULL) && (visit!=NULL));
+	int i;
+	for(i = 0; i < mp->length; i++) {
+		if(mp->slots[i].key != NULL)
+			(*visit)(mp->slots[i].key, mp->slots[i].value, arg);
+	}
+}
+
+
+/*
+ *  Time Complexity: O(n)
+ *  Description: Returns the smallest power of two table length that keeps
+ *  n pairs at or below half full
+ */
+static int tableLength(int n) {
+	int length = MIN_LENGTH;
+	while(length < 2*n) {
+		assert(length <= INT_MAX/2);
+		length *= 2;
+	}
+	return length;
+}
+
+
+/*
+ *  Time Complexity: O(log n)
+ *  Description: Returns how far a hash is shifted right to give its home slot in a
+ *  table of the given power of two length
+ */
+static int tableShift(int length) {
+	int shift = 32;
+	while(length > 1) {
+		length /= 2;
+		shift--;
+	}
+	return shift;
+}
+
+
+/*
+ *  Time Complexity: O(n)
+ *  Description: Moves every pair of MAP mp into a new table of the given length,
+ *  placing each by its cached hash without reading the key again
+ */
+static void rehash(MAP *mp, int length) {
+	SLOT *slots = mp->slots;
+	int oldLength = mp->length;
+	int i;
+	mp->length = length;
+	mp->shift = tableShift(length);
+	mp->slots = malloc(sizeof(SLOT)*length);
+	assert(mp->slots!=NULL);
+	for(i = 0; i < length; i++)
+		mp->slots[i].key = NULL;
+	for(i = 0; i < oldLength; i++) {
+		if(slots[i].key != NULL)
+			insert(mp, home(mp, slots[i].hash), 0, slots[i]);
+	}
+	free(slots);
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1) amortized]
+ *  Description: Adds a copy of key, whose hash, length and value are in slot, at index
+ *  and dist as found by search, growing the table first once more than three
+ *  quarters of its slots are full
+ */
+static void add(MAP *mp, char *key, SLOT slot, int index, int dist) {
+	bool found;
+	if(4*(mp->count + 1) > 3*mp->length) {
+		rehash(mp, tableLength(mp->count + 1));
+		index = search(mp, key, slot.hash, slot.length, &found, &dist);
+	}
+	slot.key = allocate(mp, key, slot.length);
+	insert(mp, index, dist, slot);
+	mp->count++;
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1) amortized]
+ *  Description: Removes the pair at index by shifting the rest of its cluster back
+ *  one slot, and shrinks the table once fewer than one eighth of its slots are full.
+ *  The key's space is reclaimed once removed keys take up more block space than
+ *  present ones
+ */
+static void erase(MAP *mp, int index) {
+	mp->live -= mp->slots[index].length + 1;
+	mp->dead += mp->slots[index].length + 1;
+	int next = (index + 1) & (mp->length - 1);
+	/* stops at an empty slot or a pair already home */
+	while(mp->slots[next].key != NULL && distance(mp, next) > 0) {
+		mp->slots[index] = mp->slots[next];
+		index = next;
+		next = (next + 1) & (mp->length - 1);
+	}
+	mp->slots[index].key = NULL;
+	mp->count--;
+	if(mp->length > MIN_LENGTH && 8*mp->count < mp->length)
+		rehash(mp, tableLength(mp->count));
+	if(mp->dead > BLOCK_SIZE && mp->dead > mp->live)
+		compact(mp);
+}
+
+
+/*
+ *  Time Complexity: O(n)
+ *  Description: Copies s, of the given length, into the space left in the newest
+ *  block of MAP mp, null terminated, starting a new block when it does not fit
+ */
+static char *allocate(MAP *mp, char *s, int length) {
+	BLOCK *bp = mp->blocks;
+	if(bp == NULL || bp->used + length + 1 > bp->size) {
+		int size = (length + 1 > BLOCK_SIZE) ? length + 1 : BLOCK_SIZE;
+		bp = malloc(sizeof(BLOCK) + size);
+		assert(bp!=NULL);
+		bp->next = mp->blocks;
+		bp->used = 0;
+		bp->size = size;
+		mp->blocks = bp;
+	}
+	char *copy = bp->text + bp->used;
+	memcpy(copy, s, length);
+	copy[length] = '\0';
+	bp->used += length + 1;
+	mp->live += length + 1;
+	return copy;
+}
+
+
+/*
+ *  Time Complexity: O(n)
+ *  Description: Copies every present key of MAP mp into fresh blocks and frees the
+ *  old ones, reclaiming the space of removed keys
+ */
+static void compact(MAP *mp) {
+	BLOCK *old = mp->blocks;
+	BLOCK *bp;
+	int i;
+	mp->blocks = NULL;
+	mp->live = 0;
+	mp->dead = 0;
+	for(i = 0; i < mp->length; i++) {
+		if(mp->slots[i].key != NULL)
+			mp->slots[i].key = allocate(mp, mp->slots[i].key, mp->slots[i].length);
+	}
+	while(old != NULL) {
+		bp = old;
+		old = bp->next;
+		free(bp);
+	}
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1)]
+ *  Description: Places slot at index, which is dist slots from its home, using Robin
+ *  Hood hashing: whenever the pair being placed is farther from home than the one
+ *  occupying a slot, they trade places and the displaced pair moves on
+ */
+static void insert(MAP *mp, int index, int dist, SLOT slot) {
+	SLOT temp;
+	int tempDist;
+	while(mp->slots[index].key != NULL) {
+		tempDist = distance(mp, index);
+		if(tempDist < dist) {
+			temp = mp->slots[index];
+			mp->slots[index] = slot;
+			slot = temp;
+			dist = tempDist;
+		}
+		index = (index + 1) & (mp->length - 1);
+		dist++;
+	}
+	mp->slots[index] = slot;
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1)]
+ *  Description: Locates key in the hash table using linear probing, stopping early
+ *  once a slot holds a pair closer to its home than key would be.  Keys are only
+ *  compared with memcmp when their cached hash and length match.  If the key is not
+ *  found, returns the slot where it belongs and its distance from home through dist
+ */
+static int search(MAP *mp, char *key, unsigned hash, int length, bool *found, int *dist) {
+	int index = home(mp, hash);
+	int i = 0;
+	while(mp->slots[index].key != NULL && distance(mp, index) >= i) {
+		if(mp->slots[index].hash == hash && mp->slots[index].length == length
+				&& memcmp(mp->slots[index].key, key, length) == 0) {
+			*found = true;
+			*dist = i;
+			return index;
+		}
+		index = (index + 1) & (mp->length - 1);
+		i++;
+	}
+	*found = false;
+	*dist = i;
+	return index;
+}
@@ -0,0 +1,34 @@
+/*
+ * File:        map.h
+ *
+ * Description: This file contains the public function and type
+ *              declarations for a map abstract data type from strings to
+ *              long integer values.  Keys are given as a pointer and a
+ *              length and need not be null terminated; the map keeps its
+ *              own null terminated copy of each key, which stays valid
+ *              only until the next key is removed, since removing keys may
+ *              move the copies of all the others.
+ */
+
+# ifndef MAP_H
+# define MAP_H
+
+typedef struct map MAP;
+
+MAP *createMap(int maxElts);
+
+void destroyMap(MAP *mp);
+
+int numPairs(MAP *mp);
+
+long increment(MAP *mp, char *key, int length, long delta);
+
+void setValue(MAP *mp, char *key, int length, long value);
+
+long *findValue(MAP *mp, char *key, int length);
+
+void removePair(MAP *mp, char *key, int length);
+
+void forEachPair(MAP *mp, void (*visit)(char *key, long value, void *arg), void *arg);
+
+# endif /* MAP_H */
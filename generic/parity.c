@@ -15,7 +15,16 @@
 # include <stdio.h>
 # include <stdlib.h>
 # include <string.h>
+# include <assert.h>
 # include "set.h"
+# include "hash.h"
+# include "token.h"
+
+
+struct word {
+    char *text;
+    int length;
+};
 
 
 /* This is sufficient for the test cases in /scratch/coen12. */
@@ -24,20 +33,69 @@
 
 
 /*
- * Function:    strhash
+ * Function:	hashWord
+ *
+ * Description:	Return a hash value for a word.
+ */
+
+static unsigned hashWord(struct word *wp)
+{
+    return hashBytes(wp->text, wp->length);
+}
+
+
+/*
+ * Function:	compareWords
+ *
+ * Description:	Compare two words as in strcmp().  The text of a word need
+ *		not be null terminated.
+ */
+
+static int compareWords(struct word *wp1, struct word *wp2)
+{
+    int cmp;
+
+
+    cmp = memcmp(wp1->text, wp2->text,
+	wp1->length < wp2->length ? wp1->length : wp2->length);
+
+    return cmp != 0 ? cmp : wp1->length - wp2->length;
+}
+
+
+/*
+ * Function:    copyWord
  *
- * Description: Return a hash value for a string S.
+ * Description: Return a copy of a word, with its text null terminated,
+ *		for adding to a set.
  */
 
-static unsigned strhash(char *s)
+static void *copyWord(struct word *wp)
 {
-    unsigned hash = 0;
+    struct word *copy;
 
 
-    while (*s != '\0')
-        hash = 31 * hash + *s ++;
+    copy = malloc(sizeof(struct word));
+    assert(copy != NULL);
 
-    return hash;
+    copy->text = strndup(wp->text, wp->length);
+    assert(copy->text != NULL);
+
+    copy->length = wp->length;
+    return copy;
+}
+
+
+/*
+ * Function:    freeWord
+ *
+ * Description: Free a word made by copyWord.
+ */
+
+static void freeWord(struct word *wp)
+{
+    free(wp->text);
+    free(wp);
 }
 
 
@@ -49,8 +107,8 @@ static unsigned strhash(char *s)
 
 int main(int argc, char *argv[])
 {
-    FILE *fp;
-    char buffer[BUFSIZ], *word;
+    TOKENS *tp;
+    struct word w, *wp;
     SET *odd;
     int words;
 
@@ -62,7 +120,7 @@ int main(int argc, char *argv[])
         exit(EXIT_FAILURE);
     }
 
-    if ((fp = fopen(argv[1], "r")) == NULL) {
+    if ((tp = openTokens(argv[1])) == NULL) {
         fprintf(stderr, "%s: cannot open %s\n", argv[0], argv[1]);
         exit(EXIT_FAILURE);
     }
@@ -71,21 +129,18 @@ int main(int argc, char *argv[])
     /* Insert or delete words to compute their parity. */
 
     words = 0;
-    odd = createSet(MAX_SIZE, strcmp, strhash);
+    odd = createSet(MAX_SIZE, compareWords, hashWord);
 
-    while (fscanf(fp, "%s", buffer) == 1) {
+    while (nextToken(tp, &w.text, &w.length)) {
         words ++;
 
-        if ((word = findElement(odd, buffer)) != NULL) {
-            removeElement(odd, buffer);
-	    free(word);
-	} else
-            addElement(odd, strdup(buffer));
+        if ((wp = toggleElement(odd, &w, copyWord)) != NULL)
+	    freeWord(wp);
     }
 
     printf("%d total words\n", words);
     printf("%d words occur an odd number of times\n", numElements(odd));
-    fclose(fp);
+    closeTokens(tp);
 
     destroySet(odd);
     exit(EXIT_SUCCESS);
@@ -0,0 +1,159 @@
+/*
+ * Description: Count-min sketch for strings.  depth rows of width counters each hold
+ * every count, with each row indexing its counter by a different hash of the key,
+ * and the estimate for a key is the least of its depth counters.  Rows are indexed
+ * by h1 + i*h2 from the two halves of one 64 bit hash, so a key is read only once
+ * however deep the sketch is.  Memory is fixed at creation, whatever is counted.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+#include "sketch.h"
+#include "hash.h"
+
+#define MAX_DEPTH 32
+
+struct sketch {
+	int width;
+	int depth;
+	long total;
+	long *counters;
+};
+
+static void locate(SKETCH *sk, char *key, int length, long *cells[]);
+
+
+/*
+ * Time Complexity: O(width*depth)
+ * Description: Creates a sketch of depth rows of width counters, all zero
+ */
+SKETCH *createSketch(int width, int depth) {
+	assert((width > 0) && (depth > 0) && (depth <= MAX_DEPTH));
+	SKETCH *sk = malloc(sizeof(SKETCH));
+	assert(sk!=NULL);
+	sk->width = width;
+	sk->depth = depth;
+	sk->total = 0;
+	sk->counters = calloc((size_t) width*depth, sizeof(long));
+	assert(sk->counters!=NULL);
+	return sk;
+}
+
+
+/*
+ * Time Complexity: O(width*depth)
+ * Description: Creates the smallest sketch whose estimates exceed the true counts by
+ * more than epsilon times the total of all counts with probability at most delta
+ */
+SKETCH *createSketchForError(double epsilon, double delta) {
+	assert((epsilon > 0) && (delta > 0) && (delta < 1));
+	return createSketch((int) ceil(M_E/epsilon), (int) ceil(log(1/delta)));
+}
+
+
+/*
+ * Time Complexity: O(1)
+ * Description: Frees all memory associated with SKETCH sk
+ */
+void destroySketch(SKETCH *sk) {
+	assert(sk!=NULL);
+	free(sk->counters);
+	free(sk);
+}
+
+
+/*
+ * Time Complexity: O(1)
+ * Description: Returns the number of counters in each row of SKETCH sk
+ */
+int sketchWidth(SKETCH *sk) {
+	assert(sk!=NULL);
+	return sk->width;
+}
+
+
+/*
+ * Time Complexity: O(1)
+ * Description: Returns the number of rows of SKETCH sk
+ */
+int sketchDepth(SKETCH *sk) {
+	assert(sk!=NULL);
+	return sk->depth;
+}
+
+
+/*
+ * Time Complexity: O(1)
+ * Description: Returns the total of all counts added to SKETCH sk
+ */
+long totalCount(SKETCH *sk) {
+	assert(sk!=NULL);
+	return sk->total;
+}
+
+
+/*
+ * Time Complexity: O(depth)
+ * Description: Adds delta, which must not be negative, to the count of the length
+ * bytes at key in SKETCH sk and returns the new estimate.  Uses conservative update:
+ * only the counters that would otherwise fall below the new estimate are raised,
+ * which keeps every estimate an upper bound while adding less error
+ */
+long addCount(SKETCH *sk, char *key, int length, long delta) {
+	assert((sk!=NULL) && (key!=NULL) && (length >= 0) && (delta >= 0));
+	long *cells[MAX_DEPTH];
+	long estimate;
+	int i;
+	locate(sk, key, length, cells);
+	estimate = *cells[0];
+	for(i = 1; i < sk->depth; i++) {
+		if(*cells[i] < estimate)
+			estimate = *cells[i];
+	}
+	estimate += delta;
+	for(i = 0; i < sk->depth; i++) {
+		if(*cells[i] < estimate)
+			*cells[i] = estimate;
+	}
+	sk->total += delta;
+	return estimate;
+}
+
+
+/*
+ * Time Complexity: O(depth)
+ * Description: Returns the estimated count of the length bytes at key in SKETCH sk
+ */
+long estimateCount(SKETCH *sk, char *key, int length) {
+	assert((sk!=NULL) && (key!=NULL) && (length >= 0));
+	long *cells[MAX_DEPTH];
+	long estimate;
+	int i;
+	locate(sk, key, length, cells);
+	estimate = *cells[0];
+	for(i = 1; i < sk->depth; i++) {
+		if(*cells[i] < estimate)
+			estimate = *cells[i];
+	}
+	return estimate;
+}
+
+
+/*
+ * Time Complexity: O(depth)
+ * Description: Stores in cells the counter of each row of SKETCH sk for the length
+ * bytes at key.  The row's hash is mapped onto its width by multiplying and keeping
+ * the high half, which needs no division
+ */
+static void locate(SKETCH *sk, char *key, int length, long *cells[]) {
+	unsigned long long hash = hashBytes(key, length);
+	unsigned h1 = hash;
+	unsigned h2 = (hash >> 32) | 1;
+	int i;
+	for(i = 0; i < sk->depth; i++) {
+		cells[i] = sk->counters + (size_t) i*sk->width + (((unsigned long long) h1*sk->width) >> 32);
+		h1 += h2;
+	}
+}
@@ -0,0 +1,33 @@
+/*
+ * File:        sketch.h
+ *
+ * Description: This file contains the public function and type
+ *              declarations for a count-min sketch, which estimates how
+ *              many times each string has been counted in a fixed amount
+ *              of memory.  An estimate is never less than the true count,
+ *              and exceeds it by more than e/width times the total of all
+ *              counts with probability at most exp(-depth).
+ */
+
+# ifndef SKETCH_H
+# define SKETCH_H
+
+typedef struct sketch SKETCH;
+
+SKETCH *createSketch(int width, int depth);
+
+SKETCH *createSketchForError(double epsilon, double delta);
+
+void destroySketch(SKETCH *sk);
+
+int sketchWidth(SKETCH *sk);
+
+int sketchDepth(SKETCH *sk);
+
+long totalCount(SKETCH *sk);
+
+long addCount(SKETCH *sk, char *key, int length, long delta);
+
+long estimateCount(SKETCH *sk, char *key, int length);
+
+# endif /* SKETCH_H */
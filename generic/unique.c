@@ -11,14 +11,26 @@
  *              are inserted into the set and the counts of total words and
  *              total words in the set are printed.  If the second file is
  *              given then all words in the second file are deleted from
- *              the set and the count printed.
+ *              the set and the count printed.  With -f, a Bloom filter
+ *              is put in front of the set before the second file is read,
+ *              so words that were never in the set are passed over
+ *              without probing its table.
  */
 
 # include <stdio.h>
 # include <stdlib.h>
 # include <string.h>
 # include <stdbool.h>
+# include <assert.h>
 # include "set.h"
+# include "hash.h"
+# include "token.h"
+
+
+struct word {
+    char *text;
+    int length;
+};
 
 
 /* This is sufficient for the test cases in /scratch/coen12. */
@@ -27,20 +39,69 @@
 
 
 /*
- * Function:    strhash
+ * Function:	hashWord
+ *
+ * Description:	Return a hash value for a word.
+ */
+
+static unsigned hashWord(struct word *wp)
+{
+    return hashBytes(wp->text, wp->length);
+}
+
+
+/*
+ * Function:	compareWords
+ *
+ * Description:	Compare two words as in strcmp().  The text of a word need
+ *		not be null terminated.
+ */
+
+static int compareWords(struct word *wp1, struct word *wp2)
+{
+    int cmp;
+
+
+    cmp = memcmp(wp1->text, wp2->text,
+	wp1->length < wp2->length ? wp1->length : wp2->length);
+
+    return cmp != 0 ? cmp : wp1->length - wp2->length;
+}
+
+
+/*
+ * Function:    copyWord
  *
- * Description: Return a hash value for a string S.
+ * Description: Return a copy of a word, with its text null terminated,
+ *		for adding to a set.
  */
 
-static unsigned strhash(char *s)
+static void *copyWord(struct word *wp)
 {
-    unsigned hash = 0;
+    struct word *copy;
+
+
+    copy = malloc(sizeof(struct word));
+    assert(copy != NULL);
+
+    copy->text = strndup(wp->text, wp->length);
+    assert(copy->text != NULL);
+
+    copy->length = wp->length;
+    return copy;
+}
 
 
-    while (*s != '\0')
-        hash = 31 * hash + *s ++;
+/*
+ * Function:    freeWord
+ *
+ * Description: Free a word made by copyWord.
+ */
 
-    return hash;
+static void freeWord(struct word *wp)
+{
+    free(wp->text);
+    free(wp);
 }
 
 
@@ -52,17 +113,21 @@ static unsigned strhash(char *s)
 
 int main(int argc, char *argv[])
 {
-    FILE *fp;
-    char buffer[BUFSIZ], **elts, *word;
+    TOKENS *tp;
+    struct word w, *wp, **elts;
     SET *unique;
     int i, words;
-    bool lflag = false;
+    bool lflag = false, fflag = false;
 
 
     /* Check usage and open the first file. */
 
-    if (argc > 1 && strcmp(argv[1], "-l") == 0) {
-	lflag = true;
+    while (argc > 1 && (strcmp(argv[1], "-l") == 0 || strcmp(argv[1], "-f") == 0)) {
+	if (argv[1][1] == 'l')
+	    lflag = true;
+	else
+	    fflag = true;
+
 	argc --;
 
 	for (i = 1; i < argc; i ++)
@@ -70,11 +135,11 @@ int main(int argc, char *argv[])
     }
 
     if (argc == 1 || argc > 3) {
-        fprintf(stderr, "usage: %s [-l] file1 [file2]\n", argv[0]);
+        fprintf(stderr, "usage: %s [-l] [-f] file1 [file2]\n", argv[0]);
         exit(EXIT_FAILURE);
     }
 
-    if ((fp = fopen(argv[1], "r")) == NULL) {
+    if ((tp = openTokens(argv[1])) == NULL) {
         fprintf(stderr, "%s: cannot open %s\n", argv[0], argv[1]);
         exit(EXIT_FAILURE);
     }
@@ -83,15 +148,14 @@ int main(int argc, char *argv[])
     /* Insert all words into the set. */
 
     words = 0;
-    unique = createSet(MAX_SIZE, strcmp, strhash);
+    unique = createSet(MAX_SIZE, compareWords, hashWord);
 
-    while (fscanf(fp, "%s", buffer) == 1) {
+    while (nextToken(tp, &w.text, &w.length)) {
         words ++;
-	if (!findElement(unique, buffer))
-	    addElement(unique, strdup(buffer));
+	insertOrGet(unique, &w, copyWord);
     }
 
-    fclose(fp);
+    closeTokens(tp);
 
     if (!lflag) {
 	printf("%d total words\n", words);
@@ -102,7 +166,7 @@ int main(int argc, char *argv[])
     /* Try to open the second file. */
 
     if (argc == 3) {
-        if ((fp = fopen(argv[2], "r")) == NULL) {
+        if ((tp = openTokens(argv[2])) == NULL) {
             fprintf(stderr, "%s: cannot open %s\n", argv[0], argv[2]);
             exit(EXIT_FAILURE);
         }
@@ -110,14 +174,15 @@ int main(int argc, char *argv[])
 
         /* Delete all words in the second file. */
 
-        while (fscanf(fp, "%s", buffer) == 1) {
-	    if ((word = findElement(unique, buffer)) != NULL) {
-		removeElement(unique, buffer);
-		free(word);
-	    }
+	if (fflag)
+	    setFilter(unique, true);
+
+        while (nextToken(tp, &w.text, &w.length)) {
+	    if ((wp = removeElement(unique, &w)) != NULL)
+		freeWord(wp);
 	}
 
-	fclose(fp);
+	closeTokens(tp);
 
 	if (!lflag)
 	    printf("%d remaining words\n", numElements(unique));
@@ -130,7 +195,7 @@ int main(int argc, char *argv[])
 	elts = getElements(unique);
 
 	for (i = 0; i < numElements(unique); i ++)
-	    printf("%s\n", elts[i]);
+	    printf("%s\n", elts[i]->text);
 
 	free(elts);
     }
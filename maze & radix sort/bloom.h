@@ -0,0 +1,29 @@
+/*
+ * File:        bloom.h
+ *
+ * Description: This file contains the public function and type
+ *              declarations for a blocked Bloom filter over 32 bit hashes.
+ *              A test reads a single 64 byte block and never misses a hash
+ *              that was added, while one for a hash never added succeeds
+ *              about once in a thousand times for up to a million hashes,
+ *              rising beyond that as 32 bit hashes begin to collide.
+ */
+
+# ifndef BLOOM_H
+# define BLOOM_H
+
+typedef struct bloom BLOOM;
+
+BLOOM *createBloom(int capacity);
+
+void destroyBloom(BLOOM *bp);
+
+void clearBloom(BLOOM *bp);
+
+int bloomFull(BLOOM *bp);
+
+void addToBloom(BLOOM *bp, unsigned hash);
+
+int testBloom(BLOOM *bp, unsigned hash);
+
+# endif /* BLOOM_H */
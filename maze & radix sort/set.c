@@ -3,27 +3,69 @@
  * COEN 12
  * Project 4
  * 05/09/2021
- * Description: ADT Implementation Utilizing Hashing with Chaining and Circular Linked Lists
+ * Description: ADT Implementation Utilizing Hashing with Chaining
+ * Each bucket is a chain of blocks the size of a cache line, holding up to SLOTS
+ * elements beside one byte of each element's hash.  A lookup compares the byte
+ * first and calls compare only when it matches, so finding an element usually
+ * reads a single line of the bucket array and the element itself.  Only the last
+ * block of a chain is ever partly full, and the first is stored in the array.
+ * The bucket array doubles once there are more than MAX_LOAD elements per bucket.
+ * Rather than moving every element at once, the old array is kept beside the new
+ * one and each addition or removal moves the chains of a few more old buckets
+ * across, so no single operation ever pays for a whole rehash.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
 #include <string.h>
-#include "list.h"
 #include "set.h"
+#include "bloom.h"
 
-#define LENGTH 30
+#define MIN_LENGTH 8
+#define STEP 2
+#define SLOTS 6
+#define MAX_LOAD 4
 
-/* Data structure for SET */
+/* A block of a bucket's chain, 64 bytes long and aligned to 64 so that it fills one
+   cache line.  tags[i] is the top byte of the hash of elts[i] */
+typedef struct block {
+	unsigned char tags[SLOTS];
+	unsigned char count;
+	struct block *next;
+	void *elts[SLOTS];
+} BLOCK;
+
+/* Data structure for SET: lists is the bucket array, a power of two long, holding
+   the first block of each bucket.  While the set is growing, old is the previous
+   array, and its buckets before moved have already been emptied into lists.
+   filter holds the hash of every element, and of some since removed, or is NULL */
 struct set {
 	int count;
 	int length;
-	LIST **lists;
+	BLOCK *lists;
+	BLOCK *old;
+	int oldLength;
+	int moved;
+	int transpose;
+	BLOOM *filter;
 	int (*compare)();
 	unsigned (*hash)();
 };
 
+static BLOCK *createBuckets(int length);
+static BLOCK *bucket(SET *sp, unsigned hash);
+static void **search(SET *sp, BLOCK *bp, unsigned hash, void *elt);
+static void insert(BLOCK *bp, unsigned hash, void *elt);
+static void erase(BLOCK *bp, void **slot);
+static void **promote(BLOCK *bp, void **slot);
+static BLOCK *blockOf(void **slot);
+static void freeChain(BLOCK *bp);
+static void grow(SET *sp);
+static void migrate(SET *sp, int n);
+static BLOCK *walkBucket(SET *sp, int index);
+static void buildFilter(SET *sp);
+
 /*
  * Time Complexity: O(1)
  * Description: Generates a new set structure
@@ -32,35 +74,67 @@ SET *createSet(int maxElts, int (*compare)(), unsigned (*hash)()) {
 	SET *sp = malloc(sizeof(SET));
 	assert(sp!=NULL);
 	sp->count = 0;
-	sp->length = LENGTH;
-	sp->lists = malloc(sizeof(LIST*)*LENGTH);
-	assert(sp->lists!=NULL);
+	sp->length = MIN_LENGTH;
+	while(sp->length*MAX_LOAD < maxElts)  /* maxElts is only a hint, since the array grows */
+		sp->length *= 2;
+	sp->lists = createBuckets(sp->length);
+	sp->old = NULL;
+	sp->oldLength = 0;
+	sp->moved = 0;
+	sp->transpose = 0;
+	sp->filter = NULL;
 	sp->compare = compare;
 	sp->hash = hash;
-
-	/* creating list at every location in hash table */
-	int i;
-	for(i = 0; i < sp->length; i++)
-		sp->lists[i] = createList(compare);
 	return sp;
 }
 
 /*
  * Time Complexity: O(n)
- * Description: Frees all memory associated with LIST lp
+ * Description: Frees all memory associated with SET sp
  */
 void destroySet(SET *sp) {
 	assert(sp!=NULL);
 	int i;
-	for(i = 0; i < sp->length; i++)
-		destroyList(sp->lists[i]);
+	for(i = 0; i < sp->length + sp->oldLength; i++)
+		freeChain(walkBucket(sp, i)->next);
 	free(sp->lists);
+	free(sp->old);
+	if(sp->filter != NULL)
+		destroyBloom(sp->filter);
 	free(sp);
 }
 
+/*
+ * Time Complexity: O(n) to turn on, O(1) to turn off
+ * Description: Turns the Bloom filter in front of SET sp on or off.  While it is on,
+ * looking up or removing an element the filter has never seen returns without
+ * reading its bucket, which helps when most elements looked up are absent
+ */
+void setFilter(SET *sp, int on) {
+	assert(sp!=NULL);
+	if(sp->filter != NULL) {
+		destroyBloom(sp->filter);
+		sp->filter = NULL;
+	}
+	if(on)
+		buildFilter(sp);
+}
+
+/*
+ * Time Complexity: O(1)
+ * Description: Turns transposition on or off for SET sp.  While it is on, each
+ * element found by findElement is swapped with the one before it in its chain, so
+ * frequently found elements drift to the front and are compared first.  Finding an
+ * element then changes the set, and so must not be done during a walk
+ */
+void setTranspose(SET *sp, int on) {
+	assert(sp!=NULL);
+	sp->transpose = on;
+}
+
 /*
  *Time Complexity: O(1)
- * Description: Returns the total number of elements in LIST lp
+ * Description: Returns the total number of elements in SET sp
  */
 int numElements(SET *sp) {
 	assert(sp!=NULL);
@@ -73,12 +147,21 @@ int numElements(SET *sp) {
  */
 void addElement(SET *sp, void *elt) {
 	assert(sp!=NULL && elt!=NULL);
-	int index = (*sp->hash)(elt) % sp->length;
-	void *item = findItem(sp->lists[index], elt);
-	if(item == NULL) {
-		addFirst(sp->lists[index], elt);
-		sp->count++;
+	migrate(sp, STEP);
+	unsigned hash = (*sp->hash)(elt);
+	BLOCK *bp = bucket(sp, hash);
+	if(search(sp, bp, hash, elt) != NULL)
+		return;
+	insert(bp, hash, elt);
+	sp->count++;
+	if(sp->filter != NULL) {
+		if(bloomFull(sp->filter))
+			buildFilter(sp);
+		else
+			addToBloom(sp->filter, hash);
 	}
+	if(sp->count > sp->length*MAX_LOAD)
+		grow(sp);
 }
 
 /*
@@ -87,12 +170,16 @@ void addElement(SET *sp, void *elt) {
  */
 void removeElement(SET *sp, void *elt) {
 	assert(sp!=NULL && elt!=NULL && sp->count > 0);
-	int index = (*sp->hash)(elt) % sp->length;
-	void *item = findItem(sp->lists[index], elt);
-	if(item != NULL) {
-		removeItem(sp->lists[index], elt);
+	unsigned hash = (*sp->hash)(elt);
+	if(sp->filter != NULL && !testBloom(sp->filter, hash))
+		return;
+	migrate(sp, STEP);
+	BLOCK *bp = bucket(sp, hash);
+	void **slot = search(sp, bp, hash, elt);
+	if(slot != NULL) {
+		erase(bp, slot);
 		sp->count--;
-	}	
+	}
 }
 
 /*
@@ -101,8 +188,16 @@ void removeElement(SET *sp, void *elt) {
  */
 void *findElement(SET *sp, void *elt) {
 	assert(sp!=NULL && elt!=NULL);
-	int index = (*sp->hash)(elt) % sp->length;
-	return findItem(sp->lists[index], elt);
+	unsigned hash = (*sp->hash)(elt);
+	if(sp->filter != NULL && !testBloom(sp->filter, hash))
+		return NULL;
+	BLOCK *bp = bucket(sp, hash);
+	void **slot = search(sp, bp, hash, elt);
+	if(slot == NULL)
+		return NULL;
+	if(sp->transpose && slot != bp->elts)
+		slot = promote(bp, slot);
+	return *slot;
 }
 
 /*
@@ -112,19 +207,289 @@ void *findElement(SET *sp, void *elt) {
 void *getElements(SET *sp) {
 	assert(sp!=NULL);
 	void **elts = malloc(sizeof(void*)*sp->count);
-	void **tempAlloc;
-	int numElts, i;
+	assert(elts!=NULL || sp->count == 0);
+	copyElements(sp, elts, sp->count);
+	return elts;
+}
+
+/*
+ * Time Complexity: O(n)
+ * Description: Copies the elements of SET sp into elts, which has room for size of
+ * them, and returns the number copied.  Each block is copied whole in one traversal
+ * of the buckets, with nothing allocated; numElements gives the size needed for all
+ */
+int copyElements(SET *sp, void *elts[], int size) {
+	assert(sp!=NULL && (elts!=NULL || size == 0) && size >= 0);
+	BLOCK *bp;
+	int i, n;
 	int index = 0;
-	for(i = 0; i < sp->length; i++) {
-		tempAlloc = getItems(sp->lists[i]);
-		numElts = numItems(sp->lists[i]);
-		memcpy(elts + index, tempAlloc, numElts*sizeof(void*));
-		index = index + numElts;
+	for(i = 0; i < sp->length + sp->oldLength && index < size; i++) {
+		for(bp = walkBucket(sp, i); bp != NULL && index < size; bp = bp->next) {
+			n = (bp->count < size - index) ? bp->count : size - index;
+			memcpy(elts + index, bp->elts, n*sizeof(void*));
+			index = index + n;
+		}
 	}
-	return elts;
+	return index;
 }
 
+/*
+ * Time Complexity: O(1) expected, O(n) worst case
+ * Description: Starts a walk over SET sp at cursor cp, returning the first element or
+ * NULL if there are none.  No copy of the set is made
+ */
+void *setBegin(SET *sp, CURSOR *cp) {
+	assert(sp!=NULL && cp!=NULL);
+	cp->index = 0;
+	cp->position = NULL;
+	return setNext(sp, cp);
+}
+
+/*
+ * Time Complexity: O(1) expected, O(n) worst case
+ * Description: Returns the element after cursor cp in SET sp and moves the cursor to
+ * it, going on to the next chain at the end of each one, or returns NULL once the
+ * walk is over.  The cursor's position is the slot of the last element returned,
+ * whose block is found from the slot's address since blocks are aligned
+ */
+void *setNext(SET *sp, CURSOR *cp) {
+	assert(sp!=NULL && cp!=NULL);
+	void **slot = cp->position;
+	BLOCK *bp;
+	while(cp->index < sp->length + sp->oldLength) {
+		if(slot == NULL) {
+			bp = walkBucket(sp, cp->index);
+			slot = bp->elts;
+		}
+		else {
+			bp = blockOf(slot);
+			slot++;
+		}
+		while(bp != NULL && slot == bp->elts + bp->count) {
+			bp = bp->next;
+			slot = (bp != NULL) ? bp->elts : NULL;
+		}
+		if(bp != NULL) {
+			cp->position = slot;
+			return *slot;
+		}
+		cp->index++;
+	}
+	cp->position = NULL;
+	return NULL;
+}
 
+/*
+ * Time Complexity: O(n)
+ * Description: Calls visit(elt, arg) on every element of SET sp
+ */
+void forEachElement(SET *sp, void (*visit)(), void *arg) {
+	assert(sp!=NULL && visit!=NULL);
+	CURSOR cursor;
+	void *elt;
+	for(elt = setBegin(sp, &cursor); elt != NULL; elt = setNext(sp, &cursor))
+		(*visit)(elt, arg);
+}
 
+/*
+ * Time Complexity: O(n) for n buckets
+ * Description: Returns an array of length empty buckets, aligned to the cache line
+ */
+static BLOCK *createBuckets(int length) {
+	BLOCK *buckets = aligned_alloc(sizeof(BLOCK), length*sizeof(BLOCK));
+	assert(buckets!=NULL);
+	memset(buckets, 0, length*sizeof(BLOCK));
+	return buckets;
+}
 
+/*
+ * Time Complexity: O(1)
+ * Description: Returns the first block of the bucket of SET sp for hash, which is in
+ * the old array if its chain there has not been moved yet
+ */
+static BLOCK *bucket(SET *sp, unsigned hash) {
+	if(sp->old != NULL && (hash & (sp->oldLength - 1)) >= sp->moved)
+		return &sp->old[hash & (sp->oldLength - 1)];
+	return &sp->lists[hash & (sp->length - 1)];
+}
 
+/*
+ * Time Complexity: O(n) for n elements in the chain
+ * Description: Returns the slot holding elt in the chain starting at block bp, or
+ * NULL if there is none.  compare is called only for slots whose tag matches hash
+ */
+static void **search(SET *sp, BLOCK *bp, unsigned hash, void *elt) {
+	unsigned char tag = hash >> 24;
+	int i;
+	for(; bp != NULL; bp = bp->next) {
+		for(i = 0; i < bp->count; i++) {
+			if(bp->tags[i] == tag && (*sp->compare)(bp->elts[i], elt) == 0)
+				return &bp->elts[i];
+		}
+	}
+	return NULL;
+}
+
+/*
+ * Time Complexity: O(n) for n elements in the chain
+ * Description: Adds elt with hash to the end of the chain starting at block bp,
+ * adding a block to the chain if the last one is full
+ */
+static void insert(BLOCK *bp, unsigned hash, void *elt) {
+	while(bp->next != NULL)
+		bp = bp->next;
+	if(bp->count == SLOTS) {
+		bp->next = aligned_alloc(sizeof(BLOCK), sizeof(BLOCK));
+		assert(bp->next!=NULL);
+		bp = bp->next;
+		bp->count = 0;
+		bp->next = NULL;
+	}
+	bp->tags[bp->count] = hash >> 24;
+	bp->elts[bp->count++] = elt;
+}
+
+/*
+ * Time Complexity: O(n) for n elements in the chain
+ * Description: Removes the element at slot from the chain starting at block bp by
+ * moving the chain's last element into it, freeing the last block if that empties
+ * it and it is not the first
+ */
+static void erase(BLOCK *bp, void **slot) {
+	BLOCK *prev = NULL;
+	BLOCK *hole = blockOf(slot);
+	int i = slot - hole->elts;
+	while(bp->next != NULL) {
+		prev = bp;
+		bp = bp->next;
+	}
+	bp->count--;
+	hole->tags[i] = bp->tags[bp->count];
+	hole->elts[i] = bp->elts[bp->count];
+	if(bp->count == 0 && prev != NULL) {
+		prev->next = NULL;
+		free(bp);
+	}
+}
+
+/*
+ * Time Complexity: O(1), or O(n) for n blocks before slot if it starts its block
+ * Description: Swaps the element at slot with the one before it in the chain
+ * starting at block bp, and returns the slot it is moved to.  Only the last block
+ * of a chain is ever partly full, so the element before the first of a block is
+ * the last of the block before
+ */
+static void **promote(BLOCK *bp, void **slot) {
+	BLOCK *hole = blockOf(slot);
+	int i = slot - hole->elts;
+	void *elt = *slot;
+	unsigned char tag = hole->tags[i];
+	BLOCK *prev = hole;
+	int j = i - 1;
+	if(i == 0) {
+		for(prev = bp; prev->next != hole; prev = prev->next)
+			;
+		j = SLOTS - 1;
+	}
+	hole->elts[i] = prev->elts[j];
+	hole->tags[i] = prev->tags[j];
+	prev->elts[j] = elt;
+	prev->tags[j] = tag;
+	return &prev->elts[j];
+}
+
+/*
+ * Time Complexity: O(1)
+ * Description: Returns the block holding slot, found from its address since every
+ * block is aligned to its size
+ */
+static BLOCK *blockOf(void **slot) {
+	return (BLOCK *) ((unsigned long) slot & ~(sizeof(BLOCK) - 1));
+}
+
+/*
+ * Time Complexity: O(n) for n blocks
+ * Description: Frees the blocks of a chain from bp on
+ */
+static void freeChain(BLOCK *bp) {
+	BLOCK *next;
+	for(; bp != NULL; bp = next) {
+		next = bp->next;
+		free(bp);
+	}
+}
+
+/*
+ * Time Complexity: O(n) for n buckets
+ * Description: Starts doubling the bucket array of SET sp, making the current array
+ * the old one to be emptied STEP buckets at a time.  Any move still under way is
+ * finished first, though STEP buckets an addition finishes each move long before the
+ * next is due
+ */
+static void grow(SET *sp) {
+	migrate(sp, sp->oldLength);
+	sp->old = sp->lists;
+	sp->oldLength = sp->length;
+	sp->moved = 0;
+	sp->length *= 2;
+	sp->lists = createBuckets(sp->length);
+}
+
+/*
+ * Time Complexity: O(n) for n buckets moved [expected O(n)]
+ * Description: Moves the chains of the next n buckets of the old array of SET sp into
+ * the new one, freeing the old array once it is empty
+ */
+static void migrate(SET *sp, int n) {
+	BLOCK *bp;
+	unsigned hash;
+	int i;
+	while(sp->old != NULL && n-- > 0) {
+		for(bp = &sp->old[sp->moved]; bp != NULL; bp = bp->next) {
+			for(i = 0; i < bp->count; i++) {
+				hash = (*sp->hash)(bp->elts[i]);
+				insert(&sp->lists[hash & (sp->length - 1)], hash, bp->elts[i]);
+			}
+		}
+		freeChain(sp->old[sp->moved].next);
+		sp->old[sp->moved].next = NULL;
+		sp->old[sp->moved].count = 0;
+		if(++sp->moved == sp->oldLength) {
+			free(sp->old);
+			sp->old = NULL;
+			sp->oldLength = 0;
+			sp->moved = 0;
+		}
+	}
+}
+
+/*
+ * Time Complexity: O(1)
+ * Description: Returns the first block of the bucket at index in a walk over SET sp,
+ * which takes in the buckets of the old array before those of the new one
+ */
+static BLOCK *walkBucket(SET *sp, int index) {
+	if(index < sp->oldLength)
+		return &sp->old[index];
+	return &sp->lists[index - sp->oldLength];
+}
+
+/*
+ * Time Complexity: O(n)
+ * Description: Replaces the filter of SET sp with one built from the hashes of its
+ * elements, with room for as many again before it fills up.  Removals leave their
+ * hashes in the filter, and this is how they are cleared out
+ */
+static void buildFilter(SET *sp) {
+	BLOCK *bp;
+	int i, j;
+	if(sp->filter != NULL)
+		destroyBloom(sp->filter);
+	sp->filter = createBloom(2*sp->count);
+	for(i = 0; i < sp->length + sp->oldLength; i++) {
+		for(bp = walkBucket(sp, i); bp != NULL; bp = bp->next) {
+			for(j = 0; j < bp->count; j++)
+				addToBloom(sp->filter, (*sp->hash)(bp->elts[j]));
+		}
+	}
+}
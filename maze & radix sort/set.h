@@ -14,10 +14,22 @@
 
 typedef struct set SET;
 
+/* The position of a walk over a set with setBegin and setNext, which the set
+   must not be changed during.  Its fields are private to the set. */
+
+typedef struct cursor {
+    int index;
+    void *position;
+} CURSOR;
+
 SET *createSet(int maxElts, int (*compare)(), unsigned (*hash)());
 
 void destroySet(SET *sp);
 
+void setTranspose(SET *sp, int on);
+
+void setFilter(SET *sp, int on);
+
 int numElements(SET *sp);
 
 void addElement(SET *sp, void *elt);
@@ -28,4 +40,12 @@ void *findElement(SET *sp, void *elt);
 
 void *getElements(SET *sp);
 
+int copyElements(SET *sp, void *elts[], int size);
+
+void *setBegin(SET *sp, CURSOR *cp);
+
+void *setNext(SET *sp, CURSOR *cp);
+
+void forEachElement(SET *sp, void (*visit)(), void *arg);
+
 # endif /* SET_H */
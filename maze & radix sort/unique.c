@@ -11,7 +11,10 @@
  *              are inserted into the set and the counts of total words and
  *              total words in the set are printed.  If the second file is
  *              given then all words in the second file are deleted from
- *              the set and the count printed.
+ *              the set and the count printed.  With -f, a Bloom filter
+ *              is put in front of the set before the second file is read,
+ *              so words that were never in the set are passed over
+ *              without probing its table.
  */
 
 # include <stdio.h>
@@ -19,6 +22,7 @@
 # include <string.h>
 # include <stdbool.h>
 # include "set.h"
+# include "hash.h"
 
 
 /* This is sufficient for the test cases in /scratch/coen12. */
@@ -26,24 +30,6 @@
 # define MAX_SIZE 18000
 
 
-/*
- * Function:    strhash
- *
- * Description: Return a hash value for a string S.
- */
-
-static unsigned strhash(char *s)
-{
-    unsigned hash = 0;
-
-
-    while (*s != '\0')
-        hash = 31 * hash + *s ++;
-
-    return hash;
-}
-
-
 /*
  * Function:    main
  *
@@ -53,16 +39,21 @@ static unsigned strhash(char *s)
 int main(int argc, char *argv[])
 {
     FILE *fp;
-    char buffer[BUFSIZ], **elts, *word;
+    char buffer[BUFSIZ], *word;
     SET *unique;
+    CURSOR cursor;
     int i, words;
-    bool lflag = false;
+    bool lflag = false, fflag = false;
 
 
     /* Check usage and open the first file. */
 
-    if (argc > 1 && strcmp(argv[1], "-l") == 0) {
-	lflag = true;
+    while (argc > 1 && (strcmp(argv[1], "-l") == 0 || strcmp(argv[1], "-f") == 0)) {
+	if (argv[1][1] == 'l')
+	    lflag = true;
+	else
+	    fflag = true;
+
 	argc --;
 
 	for (i = 1; i < argc; i ++)
@@ -70,7 +61,7 @@ int main(int argc, char *argv[])
     }
 
     if (argc == 1 || argc > 3) {
-        fprintf(stderr, "usage: %s [-l] file1 [file2]\n", argv[0]);
+        fprintf(stderr, "usage: %s [-l] [-f] file1 [file2]\n", argv[0]);
         exit(EXIT_FAILURE);
     }
 
@@ -110,6 +101,9 @@ int main(int argc, char *argv[])
 
         /* Delete all words in the second file. */
 
+	if (fflag)
+	    setFilter(unique, true);
+
         while (fscanf(fp, "%s", buffer) == 1) {
 	    if ((word = findElement(unique, buffer)) != NULL) {
 		removeElement(unique, buffer);
@@ -127,12 +121,9 @@ int main(int argc, char *argv[])
     /* Print the list of words if desired. */
 
     if (lflag) {
-	elts = getElements(unique);
-
-	for (i = 0; i < numElements(unique); i ++)
-	    printf("%s\n", elts[i]);
-
-	free(elts);
+	for (word = setBegin(unique, &cursor); word != NULL;
+		word = setNext(unique, &cursor))
+	    printf("%s\n", word);
     }
 
     destroySet(unique);
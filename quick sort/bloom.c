@@ -0,0 +1,140 @@
+/*
+ * Description: Blocked Bloom filter over 32 bit hashes.  The filter is an array of
+ * 64 byte blocks, each the size of a cache line, and a hash sets or tests one bit in
+ * each of the eight words of a single block, so every query reads one line.  The
+ * hash is mixed first, since the sets hand over hashes whose bits also pick their
+ * slots and shards.  Bits are never cleared, so a filter whose elements are removed
+ * still answers correctly, just less often; once capacity hashes have been added,
+ * counting any since removed, the owner refills it from what is left.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "bloom.h"
+
+#define WORDS 8
+#define BITS_PER_KEY 16
+#define MIN_CAPACITY 64
+
+typedef struct block {
+	unsigned long long words[WORDS];
+} BLOCK;
+
+struct bloom {
+	int count;
+	int capacity;
+	int length;
+	BLOCK *blocks;
+};
+
+static unsigned mix(unsigned hash);
+
+/* Odd multipliers giving each word of a block its own bit for the same hash */
+static const unsigned salts[WORDS] = {
+	0x47b6137b, 0x44974d91, 0x8824ad5b, 0xa2b7289d,
+	0x705495c7, 0x2df1424b, 0x9efc4947, 0x5c6bfb31
+};
+
+
+/*
+ * Time Complexity: O(n) for n = capacity
+ * Description: Creates an empty filter for up to capacity hashes, at BITS_PER_KEY
+ * bits per hash, which keeps false positives near one in a thousand
+ */
+BLOOM *createBloom(int capacity) {
+	assert(capacity >= 0);
+	BLOOM *bp = malloc(sizeof(BLOOM));
+	assert(bp!=NULL);
+	if(capacity < MIN_CAPACITY)
+		capacity = MIN_CAPACITY;
+	bp->count = 0;
+	bp->capacity = capacity;
+	bp->length = ((long) capacity*BITS_PER_KEY + 8*sizeof(BLOCK) - 1) / (8*sizeof(BLOCK));
+	bp->blocks = aligned_alloc(sizeof(BLOCK), sizeof(BLOCK)*bp->length);
+	assert(bp->blocks!=NULL);
+	memset(bp->blocks, 0, sizeof(BLOCK)*bp->length);
+	return bp;
+}
+
+
+/*
+ * Time Complexity: O(1)
+ * Description: Frees all memory associated with BLOOM bp
+ */
+void destroyBloom(BLOOM *bp) {
+	assert(bp!=NULL);
+	free(bp->blocks);
+	free(bp);
+}
+
+
+/*
+ * Time Complexity: O(n) for n = capacity
+ * Description: Empties BLOOM bp, which can then take capacity more hashes
+ */
+void clearBloom(BLOOM *bp) {
+	assert(bp!=NULL);
+	memset(bp->blocks, 0, sizeof(BLOCK)*bp->length);
+	bp->count = 0;
+}
+
+
+/*
+ * Time Complexity: O(1)
+ * Description: Returns nonzero once as many hashes have been added to BLOOM bp as it
+ * was created for, after which it should be replaced rather than added to
+ */
+int bloomFull(BLOOM *bp) {
+	assert(bp!=NULL);
+	return bp->count >= bp->capacity;
+}
+
+
+/*
+ * Time Complexity: O(1)
+ * Description: Adds hash to BLOOM bp
+ */
+void addToBloom(BLOOM *bp, unsigned hash) {
+	assert(bp!=NULL);
+	unsigned h = mix(hash);
+	BLOCK *block = &bp->blocks[((unsigned long long) h*bp->length) >> 32];
+	int i;
+	for(i = 0; i < WORDS; i++)
+		block->words[i] |= 1ULL << ((h*salts[i]) >> 26);
+	bp->count++;
+}
+
+
+/*
+ * Time Complexity: O(1)
+ * Description: Returns zero if hash has certainly not been added to BLOOM bp, and
+ * nonzero if it may have been
+ */
+int testBloom(BLOOM *bp, unsigned hash) {
+	assert(bp!=NULL);
+	unsigned h = mix(hash);
+	BLOCK *block = &bp->blocks[((unsigned long long) h*bp->length) >> 32];
+	int i;
+	for(i = 0; i < WORDS; i++) {
+		if((block->words[i] & (1ULL << ((h*salts[i]) >> 26))) == 0)
+			return 0;
+	}
+	return 1;
+}
+
+
+/*
+ * Time Complexity: O(1)
+ * Description: Returns hash with every bit mixed into every other, so that the block
+ * and the bits within it do not depend on just a few bits of the hash
+ */
+static unsigned mix(unsigned hash) {
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6b;
+	hash ^= hash >> 13;
+	hash *= 0xc2b2ae35;
+	hash ^= hash >> 16;
+	return hash;
+}
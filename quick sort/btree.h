@@ -0,0 +1,32 @@
+/*
+ * File:	btree.h
+ *
+ * Description:	This file contains the public function and type
+ *		declarations for a B-tree abstract data type for generic
+ *		pointer types.  Keys are kept in the order given by the
+ *		comparison function, which also decides when two keys are
+ *		equal, and a tree holds no two equal keys.
+ */
+
+# ifndef BTREE_H
+# define BTREE_H
+
+typedef struct btree BTREE;
+
+extern BTREE *createTree(int (*compare)());
+
+extern void destroyTree(BTREE *tp);
+
+extern int numKeys(BTREE *tp);
+
+extern void addKey(BTREE *tp, void *key);
+
+extern void removeKey(BTREE *tp, void *key);
+
+extern void *getLowerBound(BTREE *tp, void *key);
+
+extern void walkKeys(BTREE *tp, void *low, void *high, void (*visit)(), void *arg);
+
+extern void getKeys(BTREE *tp, void *keys[]);
+
+# endif /* BTREE_H */
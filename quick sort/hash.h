@@ -0,0 +1,23 @@
+/*
+ * File:        hash.h
+ *
+ * Description: This file contains the public function declarations for
+ *              the string hashing functions shared by the set abstract
+ *              data types.  Keys are hashed eight bytes at a time and
+ *              every bit of the result depends on every byte of the key.
+ *              The seed, if one is wanted, must be set before any set is
+ *              built, since changing it changes every hash value.
+ */
+
+# ifndef HASH_H
+# define HASH_H
+
+void seedHash(unsigned long long seed);
+
+unsigned long long hashBytes(const void *key, int length);
+
+unsigned strhash(char *s);
+
+void hashStrings(char *keys[], int lengths[], int n, unsigned hashes[]);
+
+# endif /* HASH_H */
@@ -0,0 +1,134 @@
+/*
+ * File:        numbers.c
+ *
+ * Description: This file contains the main function for testing the set
+ *              specialized for integers by DEFINE_SET in typedset.h.
+ *
+ *              The program works as unique does, but on integers.  It
+ *              takes two files of integers as command line arguments, the
+ *              second of which is optional.  All integers in the first file
+ *              are inserted into the set and the counts of total and
+ *              distinct integers are printed.  If the second file is given
+ *              then all integers in the second file are deleted from the
+ *              set and the count printed.  With -l, the integers left in
+ *              the set are printed in increasing order instead.
+ */
+
+# include <stdio.h>
+# include <stdlib.h>
+# include <string.h>
+# include <stdbool.h>
+# include "typedset.h"
+
+
+/* This is only a starting size, since the set grows as needed. */
+
+# define MAX_SIZE 18000
+
+# define hashInt(ip) ((unsigned) *(ip))
+# define equalInts(ip1, ip2) (*(ip1) == *(ip2))
+
+DEFINE_SET(IntSet, int, hashInt, equalInts)
+
+
+/*
+ * Function:    compareInts
+ *
+ * Description: Compare two integers for qsort().
+ */
+
+static int compareInts(const void *p1, const void *p2)
+{
+    int x = *(const int *) p1, y = *(const int *) p2;
+
+    return (x > y) - (x < y);
+}
+
+
+/*
+ * Function:    main
+ *
+ * Description: Driver function for the test application.
+ */
+
+int main(int argc, char *argv[])
+{
+    FILE *fp;
+    int i, n, numbers, *elts;
+    IntSet *unique;
+    bool lflag = false;
+
+
+    /* Check usage and open the first file. */
+
+    if (argc > 1 && strcmp(argv[1], "-l") == 0) {
+	lflag = true;
+	argc --;
+	argv ++;
+    }
+
+    if (argc == 1 || argc > 3) {
+        fprintf(stderr, "usage: numbers [-l] file1 [file2]\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if ((fp = fopen(argv[1], "r")) == NULL) {
+        fprintf(stderr, "numbers: cannot open %s\n", argv[1]);
+        exit(EXIT_FAILURE);
+    }
+
+
+    /* Insert all integers into the set. */
+
+    numbers = 0;
+    unique = createIntSet(MAX_SIZE);
+
+    while (fscanf(fp, "%d", &n) == 1) {
+        numbers ++;
+	addIntSetElement(unique, &n);
+    }
+
+    fclose(fp);
+
+    if (!lflag) {
+	printf("%d total numbers\n", numbers);
+	printf("%d distinct numbers\n", numIntSetElements(unique));
+    }
+
+
+    /* Try to open the second file. */
+
+    if (argc == 3) {
+        if ((fp = fopen(argv[2], "r")) == NULL) {
+            fprintf(stderr, "numbers: cannot open %s\n", argv[2]);
+            exit(EXIT_FAILURE);
+        }
+
+
+        /* Delete all integers in the second file. */
+
+        while (fscanf(fp, "%d", &n) == 1)
+	    removeIntSetElement(unique, &n);
+
+	fclose(fp);
+
+	if (!lflag)
+	    printf("%d remaining numbers\n", numIntSetElements(unique));
+    }
+
+
+    /* Print the list of integers if desired. */
+
+    if (lflag) {
+	elts = getIntSetElements(unique);
+	qsort(elts, numIntSetElements(unique), sizeof(int), compareInts);
+
+	for (i = 0; i < numIntSetElements(unique); i ++)
+	    printf("%d\n", elts[i]);
+
+	free(elts);
+    }
+
+    destroyIntSet(unique);
+    exit(EXIT_SUCCESS);
+}
@@ -14,18 +14,45 @@
 
 typedef struct set SET;
 
+/* The position of a walk over a set with setBegin and setNext, which the set
+   must not be changed during.  Its fields are private to the set. */
+
+typedef struct cursor {
+    int index;
+} CURSOR;
+
 SET *createSet(int maxElts, int (*compare)(), unsigned (*hash)());
 
+SET *createOrderedSet(int maxElts, int (*compare)(), unsigned (*hash)());
+
 void destroySet(SET *sp);
 
+void setFilter(SET *sp, int on);
+
+void setSortKey(SET *sp, char *(*key)());
+
 int numElements(SET *sp);
 
 void addElement(SET *sp, void *elt);
 
-void removeElement(SET *sp, void *elt);
+void *insertOrGet(SET *sp, void *elt, void *(*copy)());
+
+void *removeElement(SET *sp, void *elt);
+
+void *toggleElement(SET *sp, void *elt, void *(*copy)());
 
 void *findElement(SET *sp, void *elt);
 
 void *getElements(SET *sp);
 
+void *setBegin(SET *sp, CURSOR *cp);
+
+void *setNext(SET *sp, CURSOR *cp);
+
+void forEachElement(SET *sp, void (*visit)(), void *arg);
+
+void *lowerBound(SET *sp, void *elt);
+
+void forEachInRange(SET *sp, void *low, void *high, void (*visit)(), void *arg);
+
 # endif /* SET_H */
@@ -11,23 +11,88 @@
 #include <stdbool.h>
 #include <string.h>
 #include <assert.h>
+#include <unistd.h>
+#include <pthread.h>
 #include "set.h"
+#include "btree.h"
+#include "bloom.h"
 
-static int search(SET *sp, void *elt, bool *found);
+#define EMPTY -1
+#define CUTOFF 16
+#define PARALLEL 65536
+#define MAX_THREADS 64
 
-static void quickSort(void *data[], int (*compare)(), int start, int length);
+/* An element being sorted by its string key, with the eight bytes of the key from
+   the current depth on cached in prefix, first byte highest and zero filled past
+   the end of the key */
+typedef struct keyed {
+	unsigned long long prefix;
+	char *key;
+	void *elt;
+} KEYED;
+
+static int search(SET *sp, void *elt, unsigned hash, bool *found, int *dist);
+
+static void insert(SET *sp, int index, int dist, void *elt);
+
+static void erase(SET *sp, int index);
+
+static void addToFilter(SET *sp, unsigned hash);
+
+static void buildFilter(SET *sp);
+
+static void sortElements(void *data[], int (*compare)(), int length);
+
+static void sortRange(void *data[], int (*compare)(), int start, int length);
+
+static void quickSort(void *data[], int (*compare)(), int start, int length, int depth);
 
 static void partition(void *data[], int (*compare)(), int start, int length);
 
+static void heapSort(void *data[], int (*compare)(), int start, int length);
+
+static void siftDown(void *data[], int (*compare)(), int index, int length);
+
+static void insertionSort(void *data[], int (*compare)(), int start, int length);
+
+static void *sortRun(void *arg);
+
+static void *mergeRun(void *arg);
+
 static void swap(void *data[], int first, int second);
 
+static void keySort(void *data[], char *(*key)(), int length);
+
+static void multikeySort(KEYED *data, int length, int depth);
+
+static void keyedInsertionSort(KEYED *data, int length, int depth);
+
+static unsigned long long chunk(char *s);
+
+/* One run of a parallel sort: the elements of data from start on, which are sorted
+   in place, or whose halves before and after middle are merged into to */
+typedef struct run {
+	void **data;
+	void **to;
+	int (*compare)();
+	int start;
+	int middle;
+	int length;
+} RUN;
+
+/* dist holds each element's distance from its home slot, or EMPTY, order is the
+   B-tree over the same elements kept by an ordered set, or NULL, and filter holds
+   the hash of every element, and of some since removed, or is NULL */
 struct set{
 	void **data;
-	char *flag;
+	int *dist;
 	int count;
 	int length;
 	int (*compare)();
 	unsigned (*hash)();
+	char *(*key)();
+	BTREE *order;
+	BLOOM *filter;
 };
 
 
@@ -42,13 +107,29 @@ SET *createSet(int maxElts, int (*compare)(), unsigned (*hash)()) {
 	sp->count = 0;
 	sp->compare = compare;
 	sp->hash = hash;
+	sp->key = NULL;
+	sp->order = NULL;
+	sp->filter = NULL;
 	sp->data = malloc(sizeof(void*)*maxElts);
 	assert(sp->data!=NULL);
-	sp->flag = malloc(sizeof(char)*maxElts);
-	assert(sp->flag!=NULL);
+	sp->dist = malloc(sizeof(int)*maxElts);
+	assert(sp->dist!=NULL);
 	int i;
 	for(i = 0; i < maxElts; i++)
-		sp->flag[i] = 'E';
+		sp->dist[i] = EMPTY;
+	return sp;
+}
+
+
+/*
+ * Time Complexity: O(n)
+ * Description: Creates a new set that also keeps its elements in a B-tree ordered by
+ * compare, which every insertion and removal updates in O(log n), so getElements
+ * needs no sort and lowerBound and forEachInRange can be used
+ */
+SET *createOrderedSet(int maxElts, int (*compare)(), unsigned (*hash)()) {
+	SET *sp = createSet(maxElts, compare, hash);
+	sp->order = createTree(compare);
 	return sp;
 }
 
@@ -59,12 +140,46 @@ SET *createSet(int maxElts, int (*compare)(), unsigned (*hash)()) {
  */
 void destroySet(SET *sp) {
 	assert(sp!=NULL);
+	if(sp->order != NULL)
+		destroyTree(sp->order);
+	if(sp->filter != NULL)
+		destroyBloom(sp->filter);
 	free(sp->data);
-	free(sp->flag);
+	free(sp->dist);
 	free(sp);
 }
 
 
+/*
+ *  Time Complexity: O(1)
+ *  Description: Makes getElements sort SET sp by the null terminated string key(elt)
+ *  of each element with a multikey quick sort, instead of calling compare on pairs
+ *  of elements.  Keys must be ordered by strcmp the same way compare orders their
+ *  elements
+ */
+void setSortKey(SET *sp, char *(*key)()) {
+	assert(sp!=NULL);
+	sp->key = key;
+}
+
+
+/*
+ *  Time Complexity: O(n) to turn on, O(1) to turn off
+ *  Description: Turns the Bloom filter in front of SET sp on or off.  While it is on,
+ *  looking up or removing an element the filter has never seen returns without
+ *  probing the table, which helps when most elements looked up are absent
+ */
+void setFilter(SET *sp, int on) {
+	assert(sp!=NULL);
+	if(sp->filter != NULL) {
+		destroyBloom(sp->filter);
+		sp->filter = NULL;
+	}
+	if(on)
+		buildFilter(sp);
+}
+
+
 /*
  *  Time Complexity: O(1)
  *  Description: Returns the number of elements in SET sp
@@ -82,28 +197,96 @@ int numElements(SET *sp) {
 void addElement(SET *sp, void *elt) {
 	assert((sp!=NULL) && (elt!=NULL) && (sp->count < sp->length));
 	bool found;
-	int index = search(sp, elt, &found);
-	if((!found) && index > -1) {
-		sp->data[index] = elt;
-		sp->flag[index] = 'F';
+	int dist;
+	unsigned hash = (*sp->hash)(elt);
+	int index = search(sp, elt, hash, &found, &dist);
+	if(!found) {
+		insert(sp, index, dist, elt);
 		sp->count++;
+		if(sp->order != NULL)
+			addKey(sp->order, elt);
+		addToFilter(sp, hash);
 	}
 }
 
 
 /*
  *  Time Complexity: O(n) [expected O(1)]
- *  Description: Removes specified element from set SP
+ *  Description: Removes the element of SET sp equal to elt and returns it, or returns
+ *  NULL if there is none, with a single search of the table
  */
-void removeElement(SET *sp, void *elt) {
+void *removeElement(SET *sp, void *elt) {
 	assert((sp!=NULL) && (elt!=NULL) && (sp->count > 0));
 	bool found;
-	int index = search(sp, elt, &found);
+	int dist;
+	unsigned hash = (*sp->hash)(elt);
+	if(sp->filter != NULL && !testBloom(sp->filter, hash))
+		return NULL;
+	int index = search(sp, elt, hash, &found, &dist);
+	if(!found)
+		return NULL;
+	elt = sp->data[index];
+	if(sp->order != NULL)
+		removeKey(sp->order, elt);
+	erase(sp, index);
+	return elt;
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1)]
+ *  Description: Returns the element of SET sp equal to elt, first adding copy(elt),
+ *  or elt itself if copy is NULL, when there is none, with a single search of the table
+ */
+void *insertOrGet(SET *sp, void *elt, void *(*copy)()) {
+	assert((sp!=NULL) && (elt!=NULL));
+	bool found;
+	int dist;
+	unsigned hash = (*sp->hash)(elt);
+	int index = search(sp, elt, hash, &found, &dist);
+	if(found)
+		return sp->data[index];
+	assert(sp->count < sp->length);
+	if(copy != NULL)
+		elt = (*copy)(elt);
+	insert(sp, index, dist, elt);
+	sp->count++;
+	if(sp->order != NULL)
+		addKey(sp->order, elt);
+	addToFilter(sp, hash);
+	return elt;
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1)]
+ *  Description: Removes the element of SET sp equal to elt and returns it if there is
+ *  one, and otherwise adds copy(elt), or elt itself if copy is NULL, and returns NULL,
+ *  with a single search of the table
+ */
+void *toggleElement(SET *sp, void *elt, void *(*copy)()) {
+	assert((sp!=NULL) && (elt!=NULL));
+	bool found;
+	int dist;
+	unsigned hash = (*sp->hash)(elt);
+	int index = search(sp, elt, hash, &found, &dist);
 	if(found) {
-		sp->flag[index] = 'D';
-		sp->count--;
+		elt = sp->data[index];
+		if(sp->order != NULL)
+			removeKey(sp->order, elt);
+		erase(sp, index);
+		return elt;
 	}
-} 
+	assert(sp->count < sp->length);
+	if(copy != NULL)
+		elt = (*copy)(elt);
+	insert(sp, index, dist, elt);
+	sp->count++;
+	if(sp->order != NULL)
+		addKey(sp->order, elt);
+	addToFilter(sp, hash);
+	return NULL;
+}
 
 
 /*
@@ -113,7 +296,11 @@ void removeElement(SET *sp, void *elt) {
 void *findElement(SET *sp, void *elt) {
 	assert((sp!=NULL) && (elt!=NULL) && (sp->count >= 0));
 	bool found;
-	int index = search(sp, elt, &found);
+	int dist;
+	unsigned hash = (*sp->hash)(elt);
+	if(sp->filter != NULL && !testBloom(sp->filter, hash))
+		return NULL;
+	int index = search(sp, elt, hash, &found, &dist);
 	if(found)
 		return sp->data[index];
 	return NULL;
@@ -121,31 +308,111 @@ void *findElement(SET *sp, void *elt) {
 
 
 /*
- *  Time Complexity: O(n)
- *  Description: Returns an ordered copy of all elements in SET sp
+ *  Time Complexity: O(nlogn), or O(n) for an ordered set
+ *  Description: Returns an ordered copy of all elements in SET sp, read in order from
+ *  the B-tree of an ordered set and otherwise sorted
  */
 void *getElements(SET *sp) {
 	assert(sp!=NULL);
 	void **copy = malloc(sizeof(void*)*sp->count);
 	assert(copy!=NULL);
+	if(sp->order != NULL) {
+		getKeys(sp->order, copy);
+		return copy;
+	}
 	int i; 
 	int j = 0;
 	for(i = 0; i < sp->length; i++) {
-		if(sp->flag[i] == 'F') {
+		if(sp->dist[i] != EMPTY) {
 			copy[j] = sp->data[i];
 			j++;
 		}
 	}
-	quickSort(copy, sp->compare, 0, sp->count);
+	if(sp->key != NULL)
+		keySort(copy, sp->key, sp->count);
+	else
+		sortElements(copy, sp->compare, sp->count);
 	return copy;
 }
 
+
+/*
+ *  Time Complexity: O(logn)
+ *  Description: Returns the smallest element of ordered SET sp that is not less than
+ *  elt, or NULL if there is none
+ */
+void *lowerBound(SET *sp, void *elt) {
+	assert((sp!=NULL) && (elt!=NULL) && (sp->order!=NULL));
+	return getLowerBound(sp->order, elt);
+}
+
+
+/*
+ *  Time Complexity: O(logn + m) for m elements visited
+ *  Description: Calls visit(elt, arg) in order on every element of ordered SET sp
+ *  from low up to but not including high, where a NULL bound leaves that end open
+ */
+void forEachInRange(SET *sp, void *low, void *high, void (*visit)(), void *arg) {
+	assert((sp!=NULL) && (visit!=NULL) && (sp->order!=NULL));
+	walkKeys(sp->order, low, high, visit, arg);
+}
+
+/*
+ *  Time Complexity: O(n) [expected O(1)]
+ *  Description: Starts a walk over SET sp at cursor cp, returning the first element
+ *  or NULL if there are none.  Unlike getElements, the walk makes no copy and does
+ *  not sort, so elements come in table order
+ */
+void *setBegin(SET *sp, CURSOR *cp) {
+	assert((sp!=NULL) && (cp!=NULL));
+	cp->index = -1;
+	return setNext(sp, cp);
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1)]
+ *  Description: Returns the element after cursor cp in SET sp and moves the cursor
+ *  to it, or returns NULL once the walk is over
+ */
+void *setNext(SET *sp, CURSOR *cp) {
+	assert((sp!=NULL) && (cp!=NULL));
+	while(++cp->index < sp->length) {
+		if(sp->dist[cp->index] != EMPTY)
+			return sp->data[cp->index];
+	}
+	cp->index = sp->length;
+	return NULL;
+}
+
+
+/*
+ *  Time Complexity: O(n)
+ *  Description: Calls visit(elt, arg) on every element of SET sp in table order
+ */
+void forEachElement(SET *sp, void (*visit)(), void *arg) {
+	assert((sp!=NULL) && (visit!=NULL));
+	int i;
+	for(i = 0; i < sp->length; i++) {
+		if(sp->dist[i] != EMPTY)
+			(*visit)(sp->data[i], arg);
+	}
+}
+
+
 /* 
  * Time Complexity: O(nlogn)
- * Description: Sorts data set using the quick sort method.
+ * Description: Sorts data set using introsort: quick sort on a median of three pivot,
+ * switching to heap sort once the recursion gets deeper than depth, and leaving
+ * ranges shorter than CUTOFF to a final insertion sort pass.
  */
-void quickSort(void *data[], int (*compare)(), int start, int length) {
-	if(length > 1) {
+static void quickSort(void *data[], int (*compare)(), int start, int length, int depth) {
+	while(length > CUTOFF) {
+		if(depth == 0) {
+			heapSort(data, compare, start, length);
+			return;
+		}
+		depth--;
 		partition(data, compare, start, length);
 		int i = start;
 		int j = start + length;
@@ -156,11 +423,21 @@ void quickSort(void *data[], int (*compare)(), int start, int length) {
 				j--;
 			if(i < j-1) {
 				swap(data, i+1, j-1);
+				i++;
+				j--;
 			}
 		}
 		swap(data, start, i);
-		quickSort(data, compare, 0, i+1);
-		quickSort(data, compare, j, length-j);	
+		/* recurses on the smaller side and loops on the larger to bound the stack */
+		if(i - start < start + length - j) {
+			quickSort(data, compare, start, i - start, depth);
+			length = start + length - j;
+			start = j;
+		}
+		else {
+			quickSort(data, compare, j, start + length - j, depth);
+			length = i - start;
+		}
 	}
 }
 
@@ -168,8 +445,8 @@ void quickSort(void *data[], int (*compare)(), int start, int length) {
  * Time Complexity: O(1)
  * Description: Supplemental function for quick sort in order to locate an optimal pivot.
  */
-void partition(void *data[], int (*compare)(), int start, int length) {
-	int mid = (start + length - 1)/2;
+static void partition(void *data[], int (*compare)(), int start, int length) {
+	int mid = start + (length - 1)/2;
 	int end = start + length - 1;
 	if(compare(data[start], data[mid]) > 0) {
 		swap(data, start, mid);
@@ -183,44 +460,377 @@ void partition(void *data[], int (*compare)(), int start, int length) {
 	swap(data, start, mid);
 }
 
+/* 
+ * Time Complexity: O(nlogn)
+ * Description: Sorts the length elements from start with heap sort, the fallback
+ * that keeps introsort from going quadratic.
+ */
+static void heapSort(void *data[], int (*compare)(), int start, int length) {
+	int i;
+	for(i = length/2 - 1; i >= 0; i--)
+		siftDown(data + start, compare, i, length);
+	for(i = length - 1; i > 0; i--) {
+		swap(data + start, 0, i);
+		siftDown(data + start, compare, 0, i);
+	}
+}
+
+/* 
+ * Time Complexity: O(logn)
+ * Description: Moves the element at index down the max heap of length elements
+ * until neither child is greater.
+ */
+static void siftDown(void *data[], int (*compare)(), int index, int length) {
+	int child;
+	while((child = 2*index + 1) < length) {
+		if(child + 1 < length && compare(data[child], data[child+1]) < 0)
+			child++;
+		if(compare(data[index], data[child]) >= 0)
+			return;
+		swap(data, index, child);
+		index = child;
+	}
+}
+
+/* 
+ * Time Complexity: O(n) once every element is within CUTOFF of its place
+ * Description: Sorts the length elements from start by insertion, which finishes
+ * the short ranges quick sort leaves behind.
+ */
+static void insertionSort(void *data[], int (*compare)(), int start, int length) {
+	int i, j;
+	void *elt;
+	for(i = start + 1; i < start + length; i++) {
+		elt = data[i];
+		for(j = i; j > start && compare(data[j-1], elt) > 0; j--)
+			data[j] = data[j-1];
+		data[j] = elt;
+	}
+}
+
+/* 
+ * Time Complexity: O(nlogn)
+ * Description: Sorts length elements with introsort, bounding the recursion depth
+ * at twice the logarithm of length.
+ */
+static void sortRange(void *data[], int (*compare)(), int start, int length) {
+	int depth = 0;
+	int n;
+	for(n = length; n > 1; n /= 2)
+		depth += 2;
+	quickSort(data, compare, start, length, depth);
+	insertionSort(data, compare, start, length);
+}
+
+/* 
+ * Time Complexity: O(n/t log n) with t threads
+ * Description: Sorts data set, splitting it into one run per processor and sorting
+ * the runs in parallel when it is at least PARALLEL elements long.  Sorted runs are
+ * then merged in pairs, with the merges of each round also run in parallel.
+ */
+static void sortElements(void *data[], int (*compare)(), int length) {
+	pthread_t threads[MAX_THREADS];
+	RUN runs[MAX_THREADS];
+	bool started[MAX_THREADS];
+	int bounds[MAX_THREADS + 1];
+	void **temp, **from, **to;
+	int i, nruns, merges;
+	int nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+	if(nthreads > MAX_THREADS)
+		nthreads = MAX_THREADS;
+	if(nthreads < 2 || length < PARALLEL) {
+		sortRange(data, compare, 0, length);
+		return;
+	}
+	/* bounds[i] is where the ith sorted run starts, and bounds[nruns] is the end */
+	for(i = 0; i <= nthreads; i++)
+		bounds[i] = (long) length * i / nthreads;
+	for(i = 0; i < nthreads; i++) {
+		runs[i].data = data;
+		runs[i].compare = compare;
+		runs[i].start = bounds[i];
+		runs[i].length = bounds[i + 1] - bounds[i];
+		started[i] = pthread_create(&threads[i], NULL, sortRun, &runs[i]) == 0;
+		if(!started[i])  /* no thread to spare, so sort the run here */
+			sortRun(&runs[i]);
+	}
+	for(i = 0; i < nthreads; i++) {
+		if(started[i])
+			pthread_join(threads[i], NULL);
+	}
+	temp = malloc(sizeof(void*)*length);
+	assert(temp!=NULL);
+	from = data;
+	to = temp;
+	for(nruns = nthreads; nruns > 1; nruns = merges) {
+		merges = 0;
+		for(i = 0; i < nruns; i += 2) {
+			runs[merges].data = from;
+			runs[merges].to = to;
+			runs[merges].compare = compare;
+			runs[merges].start = bounds[i];
+			runs[merges].middle = bounds[(i + 1 < nruns) ? i + 1 : nruns];
+			runs[merges].length = bounds[(i + 2 < nruns) ? i + 2 : nruns] - bounds[i];
+			started[merges] = pthread_create(&threads[merges], NULL, mergeRun, &runs[merges]) == 0;
+			if(!started[merges])
+				mergeRun(&runs[merges]);
+			merges++;
+		}
+		for(i = 0; i < merges; i++) {
+			if(started[i])
+				pthread_join(threads[i], NULL);
+			bounds[i] = runs[i].start;
+		}
+		bounds[merges] = length;
+		from = to;
+		to = (to == temp) ? data : temp;
+	}
+	if(from != data)
+		memcpy(data, from, sizeof(void*)*length);
+	free(temp);
+}
+
+/* 
+ * Time Complexity: O(nlogn)
+ * Description: Thread body sorting one run of the data set in place.
+ */
+static void *sortRun(void *arg) {
+	RUN *rp = arg;
+	sortRange(rp->data, rp->compare, rp->start, rp->length);
+	return NULL;
+}
+
+/* 
+ * Time Complexity: O(n)
+ * Description: Thread body merging the two sorted runs of a range, the one before
+ * middle and the one from middle on, into the same range of the other buffer.
+ */
+static void *mergeRun(void *arg) {
+	RUN *rp = arg;
+	int i = rp->start;
+	int j = rp->middle;
+	int end = rp->start + rp->length;
+	int k = rp->start;
+	while(i < rp->middle && j < end)
+		rp->to[k++] = (rp->compare(rp->data[j], rp->data[i]) < 0) ? rp->data[j++] : rp->data[i++];
+	while(i < rp->middle)
+		rp->to[k++] = rp->data[i++];
+	while(j < end)
+		rp->to[k++] = rp->data[j++];
+	return NULL;
+}
+
 /* 
  * Time Complexity: O(1)
  * Description: Swaps two elements in data set.
  */
-void swap(void *data[], int first, int second) {
+static void swap(void *data[], int first, int second) {
 	void *temp = data[first];
 	data[first] = data[second];
 	data[second] = temp;
 }	
 
+/* 
+ * Time Complexity: O(n log n + total length of the keys)
+ * Description: Sorts data set by the string key of each element, caching each key's
+ * first eight bytes next to it so most comparisons are of two integers in the array
+ * rather than of two strings through a function.
+ */
+static void keySort(void *data[], char *(*key)(), int length) {
+	KEYED *keyed = malloc(sizeof(KEYED)*(length > 0 ? length : 1));
+	assert(keyed!=NULL);
+	int i;
+	for(i = 0; i < length; i++) {
+		keyed[i].elt = data[i];
+		keyed[i].key = (*key)(data[i]);
+		keyed[i].prefix = chunk(keyed[i].key);
+	}
+	multikeySort(keyed, length, 0);
+	for(i = 0; i < length; i++)
+		data[i] = keyed[i].elt;
+	free(keyed);
+}
+
+/* 
+ * Time Complexity: O(n log n + total length of the keys)
+ * Description: Multikey quick sort over eight byte characters: splits the elements
+ * three ways around the median of three cached prefixes, sorts the smaller and larger
+ * parts the same way, then moves on to the next eight bytes of the equal part, unless
+ * their keys already ended there and so are all the same.
+ */
+static void multikeySort(KEYED *data, int length, int depth) {
+	KEYED temp;
+	unsigned long long pivot, a, b, c;
+	int lt, gt, i;
+	while(length > CUTOFF) {
+		a = data[0].prefix;
+		b = data[length/2].prefix;
+		c = data[length - 1].prefix;
+		pivot = (a < b) ? ((b < c) ? b : (a < c) ? c : a) : ((a < c) ? a : (b < c) ? c : b);
+		lt = 0;
+		gt = length;
+		i = 0;
+		while(i < gt) {  /* [0, lt) is less than pivot, [lt, i) equal and [gt, length) greater */
+			if(data[i].prefix < pivot) {
+				temp = data[i];
+				data[i++] = data[lt];
+				data[lt++] = temp;
+			}
+			else if(data[i].prefix > pivot) {
+				temp = data[i];
+				data[i] = data[--gt];
+				data[gt] = temp;
+			}
+			else
+				i++;
+		}
+		multikeySort(data, lt, depth);
+		multikeySort(data + gt, length - gt, depth);
+		if((pivot & 0xff) == 0)
+			return;
+		data += lt;
+		length = gt - lt;
+		depth += 8;
+		for(i = 0; i < length; i++)
+			data[i].prefix = chunk(data[i].key + depth);
+	}
+	keyedInsertionSort(data, length, depth);
+}
+
+/* 
+ * Time Complexity: O(n^2) string comparisons, for the short ranges left by multikeySort
+ * Description: Sorts by insertion elements whose keys agree before depth, comparing
+ * the cached prefixes first and the rest of the keys only when those are equal.
+ */
+static void keyedInsertionSort(KEYED *data, int length, int depth) {
+	KEYED elt;
+	int i, j;
+	for(i = 1; i < length; i++) {
+		elt = data[i];
+		for(j = i; j > 0; j--) {
+			if(data[j-1].prefix < elt.prefix)
+				break;
+			if(data[j-1].prefix == elt.prefix && ((elt.prefix & 0xff) == 0 ||
+			    strcmp(data[j-1].key + depth + 8, elt.key + depth + 8) <= 0))
+				break;
+			data[j] = data[j-1];
+		}
+		data[j] = elt;
+	}
+}
+
+/* 
+ * Time Complexity: O(1)
+ * Description: Returns the first eight bytes of string s as an integer that orders
+ * like strcmp, with the first byte highest and zeros past the end of s, which is
+ * never read beyond.
+ */
+static unsigned long long chunk(char *s) {
+	unsigned long long prefix = 0;
+	int i;
+	for(i = 0; i < 8; i++) {
+		prefix <<= 8;
+		if(*s != '\0')
+			prefix |= (unsigned char) *s++;
+	}
+	return prefix;
+}
+
 /*
  *  Time Complexity: O(n) [expected O(1)]
- *  Description: Locates a specific element in the hash table using linear probing, 
- *  returns the closest empty location to the home index if element is not found
+ *  Description: Removes the element at index by shifting the rest of its cluster
+ *  back one slot, so no deleted markers are left behind
  */
-static int search(SET *sp, void *elt, bool *found) {
-	int home = (*sp->hash)(elt) % (sp->length);
-	int deleted = -1;
-	int index, i;
-	for(i = 0; i < sp->length; i++) {
-		index = (home + i) % sp->length;
-		if(sp->flag[index] == 'D') {
-			if(deleted == -1)  /* saves first occurrence of deleted index */
-				deleted = index;
-		}
-		else if(sp->flag[index] == 'E') {
-			*found = false;  /* element was not found, returns first occurence of empty location */ 
-			if(deleted > -1)
-				return deleted;
-			return index;
+static void erase(SET *sp, int index) {
+	int next = (index + 1) % sp->length;
+	while(sp->dist[next] > 0) {  /* stops at an empty slot or an element already home */
+		sp->data[index] = sp->data[next];
+		sp->dist[index] = sp->dist[next] - 1;
+		index = next;
+		next = (next + 1) % sp->length;
+	}
+	sp->dist[index] = EMPTY;
+	sp->count--;
+}
+
+/*
+ *  Time Complexity: O(n) [expected O(1)]
+ *  Description: Places elt at index, which is dist slots from its home, using Robin
+ *  Hood hashing: whenever the element being placed is farther from home than the
+ *  one occupying a slot, they trade places and the displaced element moves on
+ */
+static void insert(SET *sp, int index, int dist, void *elt) {
+	void *tempData;
+	int tempDist;
+	while(sp->dist[index] != EMPTY) {
+		if(sp->dist[index] < dist) {
+			tempData = sp->data[index];
+			tempDist = sp->dist[index];
+			sp->data[index] = elt;
+			sp->dist[index] = dist;
+			elt = tempData;
+			dist = tempDist;
 		}
-		else if((*sp->compare)(sp->data[index], elt) == 0) {
+		index = (index + 1) % sp->length;
+		dist++;
+	}
+	sp->data[index] = elt;
+	sp->dist[index] = dist;
+}
+
+/*
+ *  Time Complexity: O(n) [expected O(1)]
+ *  Description: Locates a specific element in the hash table using linear probing,
+ *  stopping early once a slot holds an element closer to its home than elt would be.
+ *  If the element is not found, returns the slot where it belongs and its distance
+ *  from home through dist
+ */
+static int search(SET *sp, void *elt, unsigned hash, bool *found, int *dist) {
+	int index = hash % (sp->length);
+	int i;
+	for(i = 0; i < sp->length && sp->dist[index] >= i; i++) {
+		if((*sp->compare)(sp->data[index], elt) == 0) {
 			*found = true; /* element was found, returns location */
+			*dist = i;
 			return index;
 		}
+		index = (index + 1) % sp->length;
 	}
-	*found = false; /* element not found, returns first occurence of deleted location */
-	return deleted;
+	*found = false; /* element not found, returns the slot it would be placed in */
+	*dist = i;
+	return index;
 }
 
 
+/*
+ *  Time Complexity: O(n) once every n additions, otherwise O(1)
+ *  Description: Adds hash, of an element just added to SET sp, to its filter if it
+ *  has one, building a new filter instead once the old one is full
+ */
+static void addToFilter(SET *sp, unsigned hash) {
+	if(sp->filter == NULL)
+		return;
+	if(bloomFull(sp->filter))
+		buildFilter(sp);
+	else
+		addToBloom(sp->filter, hash);
+}
+
+
+/*
+ *  Time Complexity: O(n)
+ *  Description: Replaces the filter of SET sp with one built from the hashes of its
+ *  elements, with room for as many again before it fills up.  Removals leave their
+ *  hashes in the filter, and this is how they are cleared out
+ */
+static void buildFilter(SET *sp) {
+	int i;
+	if(sp->filter != NULL)
+		destroyBloom(sp->filter);
+	sp->filter = createBloom(2*sp->count);
+	for(i = 0; i < sp->length; i++) {
+		if(sp->dist[i] != EMPTY)
+			addToBloom(sp->filter, (*sp->hash)(sp->data[i]));
+	}
+}
+
@@ -0,0 +1,247 @@
+/*
+ * Description: Set ADT specialized for one element type at compile time, as an
+ * alternative to the generic set in table.c.  DEFINE_SET(NAME, TYPE, HASH, EQUAL)
+ * defines the type NAME and static functions createNAME, destroyNAME,
+ * numNAMEElements, addNAMEElement, removeNAMEElement, findNAMEElement,
+ * insertOrGetNAMEElement and getNAMEElements.  Elements are stored in the table by
+ * value instead of as void pointers, and HASH and EQUAL are called directly rather
+ * than through function pointers, so the compiler can inline them into every probe.
+ * HASH takes a pointer to an element and returns an unsigned hash value, and EQUAL
+ * takes two pointers and returns nonzero if the elements are equal; either may be a
+ * function or a macro.  A pointer returned into the table stays valid only until
+ * the next element is added or removed.  For example, a set of integers:
+ *
+ *	#define hashInt(ip) ((unsigned) *(ip))
+ *	#define equalInts(ip1, ip2) (*(ip1) == *(ip2))
+ *
+ *	DEFINE_SET(IntSet, int, hashInt, equalInts)
+ */
+
+#ifndef TYPEDSET_H
+#define TYPEDSET_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <assert.h>
+
+#define TYPEDSET_EMPTY -1
+#define TYPEDSET_MIN_LENGTH 8
+
+/* Homes are the top bits of the hash times 2^32/phi, so weak hashes such as the
+   identity on integers still spread over the whole table */
+#define TYPEDSET_HOME(hash, shift) (((unsigned) (hash) * 2654435769u) >> (shift))
+
+/* dist holds each slot's distance from its home slot, or TYPEDSET_EMPTY */
+#define DEFINE_SET(NAME, TYPE, HASH, EQUAL)						\
+typedef struct NAME {									\
+	TYPE *data;									\
+	int *dist;									\
+	int count;									\
+	int length;									\
+	int shift;									\
+} NAME;											\
+											\
+static inline void resize##NAME(NAME *sp, int n);					\
+											\
+/*											\
+ *  Time Complexity: O(n) [expected O(1)]						\
+ *  Description: Locates elt using linear probing, stopping early once a slot holds an	\
+ *  element closer to its home than elt would be.  If elt is not found, returns the	\
+ *  slot where it belongs and its distance from home through dist			\
+ */											\
+static inline int search##NAME(NAME *sp, const TYPE *elt, bool *found, int *dist) {	\
+	int index = TYPEDSET_HOME(HASH(elt), sp->shift);				\
+	int i = 0;									\
+	while(sp->dist[index] >= i) {							\
+		if(EQUAL(&sp->data[index], elt)) {					\
+			*found = true;							\
+			*dist = i;							\
+			return index;							\
+		}									\
+		index = (index + 1) & (sp->length - 1);					\
+		i++;									\
+	}										\
+	*found = false;									\
+	*dist = i;									\
+	return index;									\
+}											\
+											\
+/*											\
+ *  Time Complexity: O(n) [expected O(1)]						\
+ *  Description: Places elt at index, which is dist slots from its home, using Robin	\
+ *  Hood hashing, and returns the slot where elt itself ended up			\
+ */											\
+static inline int place##NAME(NAME *sp, int index, int dist, TYPE elt) {		\
+	int result = -1;								\
+	int tempDist;									\
+	TYPE temp;									\
+	while(sp->dist[index] != TYPEDSET_EMPTY) {					\
+		if(sp->dist[index] < dist) {						\
+			temp = sp->data[index];						\
+			tempDist = sp->dist[index];					\
+			sp->data[index] = elt;						\
+			sp->dist[index] = dist;						\
+			elt = temp;							\
+			dist = tempDist;						\
+			if(result == -1)						\
+				result = index;						\
+		}									\
+		index = (index + 1) & (sp->length - 1);					\
+		dist++;									\
+	}										\
+	sp->data[index] = elt;								\
+	sp->dist[index] = dist;								\
+	return (result == -1) ? index : result;						\
+}											\
+											\
+/*											\
+ *  Time Complexity: O(n)								\
+ *  Description: Creates a new set, maxElts is only a hint since it grows as needed	\
+ */											\
+static inline NAME *create##NAME(int maxElts) {						\
+	NAME *sp = malloc(sizeof(NAME));						\
+	assert(sp!=NULL);								\
+	sp->data = NULL;								\
+	sp->dist = NULL;								\
+	sp->count = 0;									\
+	sp->length = 0;									\
+	resize##NAME(sp, maxElts);							\
+	return sp;									\
+}											\
+											\
+/*											\
+ *  Time Complexity: O(1)								\
+ *  Description: Frees all memory associated with set sp				\
+ */											\
+static inline void destroy##NAME(NAME *sp) {						\
+	assert(sp!=NULL);								\
+	free(sp->data);									\
+	free(sp->dist);									\
+	free(sp);									\
+}											\
+											\
+/*											\
+ *  Time Complexity: O(1)								\
+ *  Description: Returns the number of elements in set sp				\
+ */											\
+static inline int num##NAME##Elements(NAME *sp) {					\
+	assert(sp!=NULL);								\
+	return sp->count;								\
+}											\
+											\
+/*											\
+ *  Time Complexity: O(n) [expected O(1) amortized]					\
+ *  Description: Returns the element of set sp equal to elt, first adding a copy of	\
+ *  elt when there is none, with a single search of the table				\
+ */											\
+static inline TYPE *insertOrGet##NAME##Element(NAME *sp, const TYPE *elt) {		\
+	assert((sp!=NULL) && (elt!=NULL));						\
+	bool found;									\
+	int dist;									\
+	int index = search##NAME(sp, elt, &found, &dist);				\
+	if(found)									\
+		return &sp->data[index];						\
+	if(4*(sp->count + 1) > 3*sp->length) {						\
+		resize##NAME(sp, sp->count + 1);					\
+		index = search##NAME(sp, elt, &found, &dist);				\
+	}										\
+	sp->count++;									\
+	return &sp->data[place##NAME(sp, index, dist, *elt)];				\
+}											\
+											\
+/*											\
+ *  Time Complexity: O(n) [expected O(1) amortized]					\
+ *  Description: Adds a copy of elt to set sp if there is no equal element		\
+ */											\
+static inline void add##NAME##Element(NAME *sp, const TYPE *elt) {			\
+	insertOrGet##NAME##Element(sp, elt);						\
+}											\
+											\
+/*											\
+ *  Time Complexity: O(n) [expected O(1) amortized]					\
+ *  Description: Removes the element equal to elt from set sp by shifting the rest of	\
+ *  its cluster back one slot, returning whether there was one				\
+ */											\
+static inline bool remove##NAME##Element(NAME *sp, const TYPE *elt) {			\
+	assert((sp!=NULL) && (elt!=NULL));						\
+	bool found;									\
+	int dist;									\
+	int index = search##NAME(sp, elt, &found, &dist);				\
+	if(!found)									\
+		return false;								\
+	int next = (index + 1) & (sp->length - 1);					\
+	while(sp->dist[next] > 0) {							\
+		sp->data[index] = sp->data[next];					\
+		sp->dist[index] = sp->dist[next] - 1;					\
+		index = next;								\
+		next = (next + 1) & (sp->length - 1);					\
+	}										\
+	sp->dist[index] = TYPEDSET_EMPTY;						\
+	sp->count--;									\
+	if(sp->length > TYPEDSET_MIN_LENGTH && 8*sp->count < sp->length)		\
+		resize##NAME(sp, sp->count);						\
+	return true;									\
+}											\
+											\
+/*											\
+ *  Time Complexity: O(n) [expected O(1)]						\
+ *  Description: Returns the element of set sp equal to elt, or NULL			\
+ */											\
+static inline TYPE *find##NAME##Element(NAME *sp, const TYPE *elt) {			\
+	assert((sp!=NULL) && (elt!=NULL));						\
+	bool found;									\
+	int dist;									\
+	int index = search##NAME(sp, elt, &found, &dist);				\
+	return found ? &sp->data[index] : NULL;						\
+}											\
+											\
+/*											\
+ *  Time Complexity: O(n)								\
+ *  Description: Returns an unordered copy of all elements in set sp			\
+ */											\
+static inline TYPE *get##NAME##Elements(NAME *sp) {					\
+	assert(sp!=NULL);								\
+	TYPE *copy = malloc(sizeof(TYPE)*(sp->count > 0 ? sp->count : 1));		\
+	assert(copy!=NULL);								\
+	int i;										\
+	int j = 0;									\
+	for(i = 0; i < sp->length; i++) {						\
+		if(sp->dist[i] != TYPEDSET_EMPTY)					\
+			copy[j++] = sp->data[i];					\
+	}										\
+	return copy;									\
+}											\
+											\
+/*											\
+ *  Time Complexity: O(n)								\
+ *  Description: Moves every element of set sp into a new table of the smallest power	\
+ *  of two length that keeps n elements at or below half full				\
+ */											\
+static inline void resize##NAME(NAME *sp, int n) {					\
+	TYPE *data = sp->data;								\
+	int *dist = sp->dist;								\
+	int oldLength = sp->length;							\
+	int length = TYPEDSET_MIN_LENGTH;						\
+	int i;										\
+	while(length < 2*n) {								\
+		assert(length <= INT_MAX/2);						\
+		length *= 2;								\
+	}										\
+	sp->length = length;								\
+	sp->shift = 32 - __builtin_ctz(length);						\
+	sp->data = malloc(sizeof(TYPE)*length);						\
+	assert(sp->data!=NULL);								\
+	sp->dist = malloc(sizeof(int)*length);						\
+	assert(sp->dist!=NULL);								\
+	for(i = 0; i < length; i++)							\
+		sp->dist[i] = TYPEDSET_EMPTY;						\
+	for(i = 0; i < oldLength; i++) {						\
+		if(dist[i] != TYPEDSET_EMPTY)						\
+			place##NAME(sp, TYPEDSET_HOME(HASH(&data[i]), sp->shift), 0, data[i]); \
+	}										\
+	free(data);									\
+	free(dist);									\
+}
+
+#endif /* TYPEDSET_H */
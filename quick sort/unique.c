@@ -11,7 +11,10 @@
  *              are inserted into the set and the counts of total words and
  *              total words in the set are printed.  If the second file is
  *              given then all words in the second file are deleted from
- *              the set and the count printed.
+ *              the set and the count printed.  With -f, a Bloom filter
+ *              is put in front of the set before the second file is read,
+ *              so words that were never in the set are passed over
+ *              without probing its table.
  */
 
 # include <stdio.h>
@@ -19,6 +22,7 @@
 # include <string.h>
 # include <stdbool.h>
 # include "set.h"
+# include "hash.h"
 
 
 /* This is sufficient for the test cases in /scratch/coen12. */
@@ -27,20 +31,14 @@
 
 
 /*
- * Function:    strhash
+ * Function:    copyString
  *
- * Description: Return a hash value for a string S.
+ * Description: Return a copy of a string S for adding to a set.
  */
 
-static unsigned strhash(char *s)
+static void *copyString(char *s)
 {
-    unsigned hash = 0;
-
-
-    while (*s != '\0')
-        hash = 31 * hash + *s ++;
-
-    return hash;
+    return strdup(s);
 }
 
 
@@ -56,13 +54,17 @@ int main(int argc, char *argv[])
     char buffer[BUFSIZ], **elts, *word;
     SET *unique;
     int i, words;
-    bool lflag = false;
+    bool lflag = false, fflag = false;
 
 
     /* Check usage and open the first file. */
 
-    if (argc > 1 && strcmp(argv[1], "-l") == 0) {
-	lflag = true;
+    while (argc > 1 && (strcmp(argv[1], "-l") == 0 || strcmp(argv[1], "-f") == 0)) {
+	if (argv[1][1] == 'l')
+	    lflag = true;
+	else
+	    fflag = true;
+
 	argc --;
 
 	for (i = 1; i < argc; i ++)
@@ -70,7 +72,7 @@ int main(int argc, char *argv[])
     }
 
     if (argc == 1 || argc > 3) {
-        fprintf(stderr, "usage: %s [-l] file1 [file2]\n", argv[0]);
+        fprintf(stderr, "usage: %s [-l] [-f] file1 [file2]\n", argv[0]);
         exit(EXIT_FAILURE);
     }
 
@@ -87,8 +89,7 @@ int main(int argc, char *argv[])
 
     while (fscanf(fp, "%s", buffer) == 1) {
         words ++;
-	if (!findElement(unique, buffer))
-	    addElement(unique, strdup(buffer));
+	insertOrGet(unique, buffer, copyString);
     }
 
     fclose(fp);
@@ -110,11 +111,12 @@ int main(int argc, char *argv[])
 
         /* Delete all words in the second file. */
 
+	if (fflag)
+	    setFilter(unique, true);
+
         while (fscanf(fp, "%s", buffer) == 1) {
-	    if ((word = findElement(unique, buffer)) != NULL) {
-		removeElement(unique, buffer);
+	    if ((word = removeElement(unique, buffer)) != NULL)
 		free(word);
-	    }
 	}
 
 	fclose(fp);
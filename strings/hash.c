@@ -0,0 +1,117 @@
+/*
+ * Description: Word-at-a-time string hashing in the style of wyhash.  Keys are
+ * read eight bytes at a time and folded in with 64x64->128 bit multiplies, so
+ * long keys and keys with shared prefixes still spread over the whole table.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "hash.h"
+
+#define P0 0xa0761d6478bd642full
+#define P1 0xe7037ed1a0b428dbull
+
+static unsigned long long mix(unsigned long long a, unsigned long long b);
+static unsigned long long read8(const unsigned char *p);
+static unsigned long long read4(const unsigned char *p);
+
+static unsigned long long seed = 0;
+
+
+/*
+ *  Time Complexity: O(1)
+ *  Description: Sets the seed mixed into every hash for the rest of the process
+ */
+void seedHash(unsigned long long s) {
+	seed = s;
+}
+
+
+/*
+ *  Time Complexity: O(n)
+ *  Description: Returns a 64 bit hash of the length bytes starting at key
+ */
+unsigned long long hashBytes(const void *key, int length) {
+	assert(key!=NULL && length >= 0);
+	const unsigned char *p = key;
+	unsigned long long h = seed ^ mix(seed ^ P0, P1);
+	unsigned long long a, b;
+	int i = length;
+	if(i <= 16) {
+		if(i >= 4) {  /* two overlapping reads cover anywhere from 4 to 16 bytes */
+			a = (read4(p) << 32) | read4(p + ((i >> 3) << 2));
+			b = (read4(p + i - 4) << 32) | read4(p + i - 4 - ((i >> 3) << 2));
+		}
+		else if(i > 0) {
+			a = ((unsigned long long) p[0] << 16) | ((unsigned long long) p[i >> 1] << 8) | p[i - 1];
+			b = 0;
+		}
+		else
+			a = b = 0;
+	}
+	else {
+		while(i > 16) {
+			h = mix(read8(p) ^ P1, read8(p + 8) ^ h);
+			p += 16;
+			i -= 16;
+		}
+		a = read8(p + i - 16);  /* the last 16 bytes, which may overlap the loop */
+		b = read8(p + i - 8);
+	}
+	return mix(P1 ^ length, mix(a ^ P1, b ^ h));
+}
+
+
+/*
+ *  Time Complexity: O(n)
+ *  Description: Returns a hash value for string s, suitable for passing to createSet
+ */
+unsigned strhash(char *s) {
+	return hashBytes(s, strlen(s));
+}
+
+
+/*
+ *  Time Complexity: O(n)
+ *  Description: Hashes n keys in one call, storing the hash of keys[i] in hashes[i].
+ *  If lengths is NULL the keys are taken to be null terminated strings
+ */
+void hashStrings(char *keys[], int lengths[], int n, unsigned hashes[]) {
+	assert(keys!=NULL && hashes!=NULL && n >= 0);
+	int i;
+	for(i = 0; i < n; i++)
+		hashes[i] = hashBytes(keys[i], lengths != NULL ? lengths[i] : strlen(keys[i]));
+}
+
+
+/*
+ *  Time Complexity: O(1)
+ *  Description: Multiplies a and b and folds the two halves of the 128 bit product
+ */
+static unsigned long long mix(unsigned long long a, unsigned long long b) {
+	unsigned __int128 r = (unsigned __int128) a * b;
+	return (unsigned long long) r ^ (unsigned long long) (r >> 64);
+}
+
+
+/*
+ *  Time Complexity: O(1)
+ *  Description: Reads eight bytes from p regardless of its alignment
+ */
+static unsigned long long read8(const unsigned char *p) {
+	unsigned long long v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+
+/*
+ *  Time Complexity: O(1)
+ *  Description: Reads four bytes from p regardless of its alignment
+ */
+static unsigned long long read4(const unsigned char *p) {
+	unsigned v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
@@ -0,0 +1,150 @@
+/*
+ * Description: HyperLogLog sketch for counting distinct strings.  The top precision
+ * bits of a key's 64 bit hash pick one of 2^precision registers, and the register
+ * keeps the longest run of leading zeros seen in the remaining bits, plus one.  The
+ * estimate is Ertl's improved estimator over the histogram of register values, which
+ * needs no switch to linear counting for small counts and so avoids the bias the
+ * original estimator shows near that switch.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+#include "hll.h"
+#include "hash.h"
+
+#define MIN_PRECISION 4
+#define MAX_PRECISION 18
+
+static double sigma(double x);
+static double tau(double x);
+
+struct hll {
+	int precision;
+	int length;
+	unsigned char *registers;
+};
+
+
+/*
+ * Time Complexity: O(m) for m = 2^precision registers
+ * Description: Creates an empty sketch with 2^precision registers
+ */
+HLL *createHLL(int precision) {
+	assert((precision >= MIN_PRECISION) && (precision <= MAX_PRECISION));
+	HLL *hp = malloc(sizeof(HLL));
+	assert(hp!=NULL);
+	hp->precision = precision;
+	hp->length = 1 << precision;
+	hp->registers = calloc(hp->length, 1);
+	assert(hp->registers!=NULL);
+	return hp;
+}
+
+
+/*
+ * Time Complexity: O(1)
+ * Description: Frees all memory associated with HLL hp
+ */
+void destroyHLL(HLL *hp) {
+	assert(hp!=NULL);
+	free(hp->registers);
+	free(hp);
+}
+
+
+/*
+ * Time Complexity: O(1) for a key of bounded length
+ * Description: Adds the length bytes at key to HLL hp
+ */
+void addToHLL(HLL *hp, char *key, int length) {
+	assert((hp!=NULL) && (key!=NULL) && (length >= 0));
+	unsigned long long hash = hashBytes(key, length);
+	int index = hash >> (64 - hp->precision);
+	unsigned long long rest = hash << hp->precision;
+	int rank = (rest == 0) ? 64 - hp->precision + 1 : __builtin_clzll(rest) + 1;
+	if(hp->registers[index] < rank)
+		hp->registers[index] = rank;
+}
+
+
+/*
+ * Time Complexity: O(m)
+ * Description: Merges HLL other into HLL hp, which then counts every string added
+ * to either.  Both must have the same precision
+ */
+void mergeHLL(HLL *hp, HLL *other) {
+	assert((hp!=NULL) && (other!=NULL) && (hp->precision == other->precision));
+	int i;
+	for(i = 0; i < hp->length; i++) {
+		if(hp->registers[i] < other->registers[i])
+			hp->registers[i] = other->registers[i];
+	}
+}
+
+
+/*
+ * Time Complexity: O(m)
+ * Description: Returns the estimated number of distinct strings added to HLL hp,
+ * from the count of registers holding each value.  Empty registers and full ones,
+ * which hold q + 1 for q = 64 - precision, are accounted for by sigma and tau
+ */
+double estimateHLL(HLL *hp) {
+	assert(hp!=NULL);
+	int q = 64 - hp->precision;
+	int counts[64 + 2] = {0};
+	double m = hp->length;
+	double z;
+	int i;
+	for(i = 0; i < hp->length; i++)
+		counts[hp->registers[i]]++;
+	z = m*tau(1 - counts[q + 1]/m);
+	for(i = q; i >= 1; i--)
+		z = 0.5*(z + counts[i]);
+	z += m*sigma(counts[0]/m);
+	return m*m/(2*log(2)*z);
+}
+
+
+/*
+ * Time Complexity: O(log precision) iterations until the sum converges
+ * Description: Returns x + sum over k >= 1 of x^(2^k) 2^(k-1), the correction for
+ * the fraction x of registers that are empty
+ */
+static double sigma(double x) {
+	double y = 1;
+	double z = x;
+	double last;
+	if(x == 1)
+		return INFINITY;
+	do {
+		x *= x;
+		last = z;
+		z += x*y;
+		y += y;
+	} while(z != last);
+	return z;
+}
+
+
+/*
+ * Time Complexity: O(log precision) iterations until the sum converges
+ * Description: Returns (1 - x - sum over k >= 1 of (1 - x^(2^-k))^2 2^-k) / 3, the
+ * correction for the registers that have reached their largest value, where x is
+ * the fraction that have not
+ */
+static double tau(double x) {
+	double y = 1;
+	double z = 1 - x;
+	double last;
+	if(x == 0 || x == 1)
+		return 0;
+	do {
+		x = sqrt(x);
+		last = z;
+		y *= 0.5;
+		z -= (1 - x)*(1 - x)*y;
+	} while(z != last);
+	return z/3;
+}
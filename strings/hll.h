@@ -0,0 +1,28 @@
+/*
+ * File:        hll.h
+ *
+ * Description: This file contains the public function and type
+ *              declarations for a HyperLogLog sketch, which estimates the
+ *              number of distinct strings added to it in 2^precision bytes.
+ *              The standard error of the estimate is about 1.04 divided by
+ *              the square root of 2^precision, or 1.6% at precision 12.
+ *              Two sketches of the same precision can be merged, giving
+ *              the sketch of every string added to either one.
+ */
+
+# ifndef HLL_H
+# define HLL_H
+
+typedef struct hll HLL;
+
+HLL *createHLL(int precision);
+
+void destroyHLL(HLL *hp);
+
+void addToHLL(HLL *hp, char *key, int length);
+
+void mergeHLL(HLL *hp, HLL *other);
+
+double estimateHLL(HLL *hp);
+
+# endif /* HLL_H */
@@ -16,6 +16,7 @@
 # include <stdlib.h>
 # include <string.h>
 # include "set.h"
+# include "token.h"
 
 
 /* This is sufficient for the test cases in /scratch/coen12. */
@@ -31,10 +32,10 @@
 
 int main(int argc, char *argv[])
 {
-    FILE *fp;
-    char buffer[BUFSIZ];
+    TOKENS *tp;
+    char *word;
     SET *odd;
-    int words;
+    int words, length;
 
 
     /* Check usage and open the file. */
@@ -44,7 +45,7 @@ int main(int argc, char *argv[])
         exit(EXIT_FAILURE);
     }
 
-    if ((fp = fopen(argv[1], "r")) == NULL) {
+    if ((tp = openTokens(argv[1])) == NULL) {
         fprintf(stderr, "%s: cannot open %s\n", argv[0], argv[1]);
         exit(EXIT_FAILURE);
     }
@@ -55,18 +56,14 @@ int main(int argc, char *argv[])
     words = 0;
     odd = createSet(MAX_SIZE);
 
-    while (fscanf(fp, "%s", buffer) == 1) {
+    while (nextToken(tp, &word, &length)) {
         words ++;
-
-        if (findElement(odd, buffer))
-            removeElement(odd, buffer);
-        else
-            addElement(odd, buffer);
+        toggleBytes(odd, word, length);
     }
 
     printf("%d total words\n", words);
     printf("%d words occur an odd number of times\n", numElements(odd));
-    fclose(fp);
+    closeTokens(tp);
 
     destroySet(odd);
     exit(EXIT_SUCCESS);
@@ -0,0 +1,237 @@
+/*
+ * File:        punique.c
+ *
+ * Description: This file contains the main function for testing a set
+ *              abstract data type for strings from several threads at once.
+ *
+ *              The program behaves like unique, but the words of each file
+ *              are split into one piece per thread, and the threads insert
+ *              or delete the words of their pieces in the same set
+ *              concurrently.  The files are read with the tokenizer in
+ *              token.c, as in unique.  The number of threads is given with
+ *              -t and defaults to four.  It must be linked with a set that
+ *              is safe to share between threads, such as the one in shard.c.
+ *              With -f, the set's Bloom filters are turned on before the
+ *              second file is read, as in unique.
+ */
+
+# include <stdio.h>
+# include <stdlib.h>
+# include <string.h>
+# include <stdbool.h>
+# include <pthread.h>
+# include "set.h"
+# include "token.h"
+
+
+/* This is only a starting size, since the set grows as needed. */
+
+# define MAX_SIZE 18000
+
+# define MAX_THREADS 256
+
+struct piece {
+    SET *sp;
+    char **words;
+    int *lengths;
+    int n;
+    bool add, threaded;
+};
+
+
+/*
+ * Function:    readWords
+ *
+ * Description: Read every word of the named file, storing pointers to the
+ *              words and their lengths in newly allocated arrays.  Return
+ *              the tokenizer, which must stay open while the words are in
+ *              use, or NULL if the file cannot be opened.
+ */
+
+static TOKENS *readWords(char *name, char ***words, int **lengths, int *n)
+{
+    TOKENS *tp;
+    char *word;
+    int length, max;
+
+
+    if ((tp = openTokens(name)) == NULL)
+        return NULL;
+
+    *n = 0;
+    max = 1024;
+    *words = malloc(sizeof(char *) * max);
+    *lengths = malloc(sizeof(int) * max);
+
+    while (nextToken(tp, &word, &length)) {
+        if (*n == max) {
+            max *= 2;
+            *words = realloc(*words, sizeof(char *) * max);
+            *lengths = realloc(*lengths, sizeof(int) * max);
+        }
+
+        if (*words == NULL || *lengths == NULL) {
+            fprintf(stderr, "punique: out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+
+        (*words)[*n] = word;
+        (*lengths)[(*n) ++] = length;
+    }
+
+    return tp;
+}
+
+
+/*
+ * Function:    work
+ *
+ * Description: Thread body: insert or delete every word in a piece.
+ */
+
+static void *work(void *arg)
+{
+    struct piece *pp = arg;
+    int i;
+
+
+    for (i = 0; i < pp->n; i ++)
+        if (pp->add)
+            addBytes(pp->sp, pp->words[i], pp->lengths[i]);
+        else
+            removeBytes(pp->sp, pp->words[i], pp->lengths[i]);
+
+    return NULL;
+}
+
+
+/*
+ * Function:    process
+ *
+ * Description: Split the n words into one piece per thread and run the
+ *              threads over the pieces.  A piece for which no thread can
+ *              be created is processed inline instead.
+ */
+
+static void process(SET *sp, char **words, int *lengths, int n,
+                    int nthreads, bool add)
+{
+    pthread_t threads[MAX_THREADS];
+    struct piece pieces[MAX_THREADS];
+    int i;
+
+
+    for (i = 0; i < nthreads; i ++) {
+        pieces[i].sp = sp;
+        pieces[i].add = add;
+        pieces[i].words = words + (long) n * i / nthreads;
+        pieces[i].lengths = lengths + (long) n * i / nthreads;
+        pieces[i].n = (long) n * (i + 1) / nthreads - (long) n * i / nthreads;
+        pieces[i].threaded = pthread_create(&threads[i], NULL, work, &pieces[i]) == 0;
+
+        if (!pieces[i].threaded)
+            work(&pieces[i]);
+    }
+
+    for (i = 0; i < nthreads; i ++)
+        if (pieces[i].threaded)
+            pthread_join(threads[i], NULL);
+}
+
+
+/*
+ * Function:    printWord
+ *
+ * Description: Print a word of the set on a line of its own.
+ */
+
+static void printWord(char *word, void *arg)
+{
+    printf("%s\n", word);
+}
+
+
+/*
+ * Function:    main
+ *
+ * Description: Driver function for the test application.
+ */
+
+int main(int argc, char *argv[])
+{
+    TOKENS *tp;
+    char **words;
+    SET *unique;
+    int n, *lengths, nthreads = 4;
+    bool lflag = false, fflag = false;
+
+
+    /* Check usage and read the first file. */
+
+    while (argc > 1 && argv[1][0] == '-') {
+        if (strcmp(argv[1], "-l") == 0)
+            lflag = true;
+        else if (strcmp(argv[1], "-f") == 0)
+            fflag = true;
+        else if (strcmp(argv[1], "-t") == 0 && argc > 2)
+            nthreads = atoi(argv[2]), argc --, argv ++;
+        else
+            break;
+
+        argc --, argv ++;
+    }
+
+    if (argc == 1 || argc > 3 || nthreads < 1 || nthreads > MAX_THREADS) {
+        fprintf(stderr, "usage: punique [-l] [-f] [-t threads] file1 [file2]\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if ((tp = readWords(argv[1], &words, &lengths, &n)) == NULL) {
+        fprintf(stderr, "punique: cannot open %s\n", argv[1]);
+        exit(EXIT_FAILURE);
+    }
+
+
+    /* Insert all words into the set. */
+
+    unique = createSet(MAX_SIZE);
+    process(unique, words, lengths, n, nthreads, true);
+    closeTokens(tp);
+    free(words);
+    free(lengths);
+
+    if (!lflag) {
+        printf("%d total words\n", n);
+        printf("%d distinct words\n", numElements(unique));
+    }
+
+
+    /* Delete all words in the second file. */
+
+    if (argc == 3) {
+        if ((tp = readWords(argv[2], &words, &lengths, &n)) == NULL) {
+            fprintf(stderr, "punique: cannot open %s\n", argv[2]);
+            exit(EXIT_FAILURE);
+        }
+
+        if (fflag)
+            setFilter(unique, true);
+
+        process(unique, words, lengths, n, nthreads, false);
+        closeTokens(tp);
+        free(words);
+        free(lengths);
+
+        if (!lflag)
+            printf("%d remaining words\n", numElements(unique));
+    }
+
+
+    /* Print the list of words if desired. */
+
+    if (lflag)
+        forEachElement(unique, printWord, NULL);
+
+    destroySet(unique);
+    exit(EXIT_SUCCESS);
+}
@@ -13,18 +13,48 @@
 
 typedef struct set SET;
 
+/* The position of a walk over a set with setBegin and setNext, which the set
+   must not be changed during.  Its fields are private to the set. */
+
+typedef struct cursor {
+    int part;
+    int index;
+} CURSOR;
+
 SET *createSet(int maxElts);
 
 void destroySet(SET *sp);
 
+void setFilter(SET *sp, int on);
+
 int numElements(SET *sp);
 
 void addElement(SET *sp, char *elt);
 
+char *insertOrGet(SET *sp, char *elt);
+
 void removeElement(SET *sp, char *elt);
 
+int toggleElement(SET *sp, char *elt);
+
 char *findElement(SET *sp, char *elt);
 
 char **getElements(SET *sp);
 
+char *setBegin(SET *sp, CURSOR *cp);
+
+char *setNext(SET *sp, CURSOR *cp);
+
+void forEachElement(SET *sp, void (*visit)(char *elt, void *arg), void *arg);
+
+SET *createSetFromArray(char *elts[], int lengths[], int n, int nthreads);
+
+void addBytes(SET *sp, char *elt, int length);
+
+void removeBytes(SET *sp, char *elt, int length);
+
+int toggleBytes(SET *sp, char *elt, int length);
+
+char *findBytes(SET *sp, char *elt, int length);
+
 # endif /* SET_H */
@@ -0,0 +1,894 @@
+/*
+ * Description: Set ADT for strings that may be shared between threads.  The set
+ * is split into shards chosen by the top bits of each element's hash, and each
+ * shard is a Robin Hood table like the one in table.c with its own lock.  Writers
+ * take the shard's lock and bump its sequence number before and after changing
+ * it, so findElement never locks: it probes the table and retries only if the
+ * sequence number shows a writer was active meanwhile.  Since a reader may still
+ * be looking at an old table or a removed string, both are retired rather than
+ * freed.  Each reader publishes the set's epoch while inside findElement, and a
+ * writer stamps what its shard has retired with a newly advanced epoch and frees
+ * it once every reader inside entered at or after that epoch.  Link with this file
+ * instead of table.c to use it behind set.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include "set.h"
+#include "hash.h"
+#include "bloom.h"
+
+#define SHARD_BITS 6
+#define SHARDS (1 << SHARD_BITS)
+#define MIN_LENGTH 8
+#define RETIRE_BATCH 64
+
+/* Each slot caches its element's full hash and string length, data is NULL if empty */
+typedef struct slot {
+	char *data;
+	unsigned hash;
+	int length;
+} SLOT;
+
+/* A table carries its own length so readers always see the two together, and
+   likewise its filter, which holds the hash of every element, and of some since
+   removed, or is NULL */
+typedef struct table {
+	struct table *next;
+	int length;
+	BLOOM *filter;
+	SLOT slots[];
+} TABLE;
+
+/* seq is odd while a writer holding lock is changing the shard, and each
+   shard sits on its own cache lines so writers to different shards do not
+   contend for them.  Retired tables hang off table->next until they are
+   stamped and moved to stamped, and the first numStamped of the retired strings
+   are stamped; stamped ones may be freed once no reader entered before stamp */
+typedef struct shard {
+	pthread_mutex_t lock;
+	unsigned seq;
+	int count;
+	TABLE *table;
+	struct set *set;
+	TABLE *stamped;
+	char **retired;
+	int numRetired;
+	int maxRetired;
+	int numStamped;
+	int reclaimAt;
+	unsigned long stamp;
+} __attribute__((aligned(64))) SHARD;
+
+/* One per thread that has looked up elements in a set, epoch is the set's epoch
+   when the thread entered findElement, or 0 while it is outside */
+typedef struct reader {
+	struct reader *next;
+	pthread_t owner;
+	unsigned long epoch;
+} __attribute__((aligned(64))) READER;
+
+/* Distance of the element in slot i from its home slot */
+#define distance(tp, i) (((i) - (tp)->slots[i].hash) & ((tp)->length - 1))
+
+/* Shard holding the elements with the given hash */
+#define shardOf(sp, hash) (&(sp)->shards[(hash) >> (32 - SHARD_BITS)])
+
+static void lockShard(SHARD *sh);
+static void unlockShard(SHARD *sh);
+static char *insertBytes(SET *sp, char *elt, int length);
+static char *probe(TABLE *tp, char *elt, int length, unsigned hash);
+static int search(TABLE *tp, char *elt, unsigned hash, int length, bool *found, int *dist);
+static void insert(TABLE *tp, int index, int dist, SLOT slot);
+static char *add(SHARD *sh, char *elt, SLOT slot, int index, int dist);
+static void erase(SHARD *sh, int index);
+static int tableLength(int n);
+static TABLE *createTable(int length);
+static void rehash(SHARD *sh, int length);
+static void fillFilter(TABLE *tp);
+static char *allocate(char *s, int length);
+static void retire(SHARD *sh, char *s);
+static void reclaim(SHARD *sh);
+static void freeStamped(SHARD *sh);
+static unsigned long advance(SET *sp, unsigned long *oldest);
+static READER *readerOf(SET *sp);
+static void *addSlice(void *arg);
+
+#define MAX_THREADS 256
+
+/* One thread's share of the elements added by createSetFromArray */
+typedef struct slice {
+	SET *sp;
+	char **elts;
+	int *lengths;
+	int n;
+} SLICE;
+
+/* id tells this set from any earlier one at the same address */
+struct set{
+	SHARD shards[SHARDS];
+	unsigned long id;
+	READER *readers;
+	unsigned long epoch __attribute__((aligned(64)));
+};
+
+/* Each thread remembers its reader for the set it last looked up elements in */
+static unsigned long numSets;
+static __thread SET *lastSet;
+static __thread unsigned long lastId;
+static __thread READER *lastReader;
+
+
+/*
+ * Time Complexity: O(n)
+ * Description: Creates a new set, maxElts is only a hint since the shards grow as needed
+ */
+SET *createSet(int maxElts) {
+	SET *sp = aligned_alloc(64, sizeof(SET));
+	assert(sp!=NULL);
+	int i;
+	for(i = 0; i < SHARDS; i++) {
+		pthread_mutex_init(&sp->shards[i].lock, NULL);
+		sp->shards[i].seq = 0;
+		sp->shards[i].count = 0;
+		sp->shards[i].table = createTable(tableLength(maxElts / SHARDS));
+		sp->shards[i].set = sp;
+		sp->shards[i].stamped = NULL;
+		sp->shards[i].retired = NULL;
+		sp->shards[i].numRetired = 0;
+		sp->shards[i].maxRetired = 0;
+		sp->shards[i].numStamped = 0;
+		sp->shards[i].reclaimAt = RETIRE_BATCH;
+		sp->shards[i].stamp = 0;
+	}
+	sp->id = __atomic_add_fetch(&numSets, 1, __ATOMIC_RELAXED);
+	sp->readers = NULL;
+	sp->epoch = 1;
+	return sp;
+}
+
+
+/*
+ *  Time Complexity: O(n)
+ *  Description: Frees all memory associated with SET sp, which no other thread may
+ *  still be using
+ */
+void destroySet(SET *sp) {
+	assert(sp!=NULL);
+	TABLE *tp;
+	READER *rp;
+	int i, j;
+	for(i = 0; i < SHARDS; i++) {
+		tp = sp->shards[i].table;
+		for(j = 0; j < tp->length; j++)
+			free(tp->slots[j].data);
+		while(sp->shards[i].table != NULL) {
+			tp = sp->shards[i].table;
+			sp->shards[i].table = tp->next;
+			if(tp->filter != NULL)
+				destroyBloom(tp->filter);
+			free(tp);
+		}
+		freeStamped(&sp->shards[i]);
+		for(j = 0; j < sp->shards[i].numRetired; j++)
+			free(sp->shards[i].retired[j]);
+		free(sp->shards[i].retired);
+		pthread_mutex_destroy(&sp->shards[i].lock);
+	}
+	while(sp->readers != NULL) {
+		rp = sp->readers;
+		sp->readers = rp->next;
+		free(rp);
+	}
+	free(sp);
+}
+
+
+/*
+ *  Time Complexity: O(n) to turn on, O(1) to turn off
+ *  Description: Turns the Bloom filters in front of the shards of SET sp on or off.
+ *  While they are on, looking up or removing a string its shard's filter has never
+ *  seen returns without probing the table.  No other thread may use the set
+ *  meanwhile, since readers could still be testing a filter being freed
+ */
+void setFilter(SET *sp, int on) {
+	assert(sp!=NULL);
+	BLOOM *filter;
+	TABLE *tp;
+	int i;
+	for(i = 0; i < SHARDS; i++) {
+		lockShard(&sp->shards[i]);
+		tp = sp->shards[i].table;
+		if(tp->filter != NULL && !on) {
+			destroyBloom(tp->filter);
+			tp->filter = NULL;
+		}
+		else if(tp->filter == NULL && on) {
+			filter = createBloom(tp->length);
+			__atomic_store_n(&tp->filter, filter, __ATOMIC_RELEASE);
+			fillFilter(tp);
+		}
+		unlockShard(&sp->shards[i]);
+	}
+}
+
+
+/*
+ *  Time Complexity: O(1)
+ *  Description: Returns the number of elements in SET sp
+ */
+int numElements(SET *sp) {
+	assert(sp!=NULL);
+	int i;
+	int count = 0;
+	for(i = 0; i < SHARDS; i++)
+		count += __atomic_load_n(&sp->shards[i].count, __ATOMIC_RELAXED);
+	return count;
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1) amortized]
+ *  Description: Adds new element to hashed location in SET sp
+ */
+void addElement(SET *sp, char *elt) {
+	assert((sp!=NULL) && (elt!=NULL));
+	insertBytes(sp, elt, strlen(elt));
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1) amortized]
+ *  Description: Adds the length bytes at elt, which need not be null terminated,
+ *  to SET sp as a string
+ */
+void addBytes(SET *sp, char *elt, int length) {
+	assert((sp!=NULL) && (elt!=NULL) && (length >= 0));
+	insertBytes(sp, elt, length);
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1) amortized]
+ *  Description: Returns the copy of elt held by SET sp, adding one first if there
+ *  is none, with a single search of the table
+ */
+char *insertOrGet(SET *sp, char *elt) {
+	assert((sp!=NULL) && (elt!=NULL));
+	return insertBytes(sp, elt, strlen(elt));
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1) amortized]
+ *  Description: Removes specified element from set SP
+ */
+void removeElement(SET *sp, char *elt) {
+	assert((sp!=NULL) && (elt!=NULL));
+	removeBytes(sp, elt, strlen(elt));
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1) amortized]
+ *  Description: Removes the string made of the length bytes at elt from SET sp
+ */
+void removeBytes(SET *sp, char *elt, int length) {
+	assert((sp!=NULL) && (elt!=NULL) && (length >= 0));
+	bool found;
+	int dist, index;
+	unsigned hash = hashBytes(elt, length);
+	SHARD *sh = shardOf(sp, hash);
+	lockShard(sh);
+	if(sh->table->filter == NULL || testBloom(sh->table->filter, hash)) {
+		index = search(sh->table, elt, hash, length, &found, &dist);
+		if(found)
+			erase(sh, index);
+	}
+	unlockShard(sh);
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1) amortized]
+ *  Description: Removes elt from SET sp if it is present and adds it otherwise, with
+ *  a single search of the table.  Returns nonzero if elt is in the set afterwards
+ */
+int toggleElement(SET *sp, char *elt) {
+	assert((sp!=NULL) && (elt!=NULL));
+	return toggleBytes(sp, elt, strlen(elt));
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1) amortized]
+ *  Description: Toggles the string made of the length bytes at elt in SET sp as
+ *  toggleElement does
+ */
+int toggleBytes(SET *sp, char *elt, int length) {
+	assert((sp!=NULL) && (elt!=NULL) && (length >= 0));
+	bool found;
+	int dist, index;
+	SLOT slot;
+	slot.length = length;
+	slot.hash = hashBytes(elt, slot.length);
+	SHARD *sh = shardOf(sp, slot.hash);
+	lockShard(sh);
+	index = search(sh->table, elt, slot.hash, slot.length, &found, &dist);
+	if(found)
+		erase(sh, index);
+	else
+		add(sh, elt, slot, index, dist);
+	unlockShard(sh);
+	return !found;
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1)]
+ *  Description: Returns location of speficied element in SET sp without taking
+ *  any lock, probing again if a writer changed the shard in the meantime.  The
+ *  string returned stays valid only until some thread removes it from the set
+ */
+char *findElement(SET *sp, char *elt) {
+	assert((sp!=NULL) && (elt!=NULL));
+	return findBytes(sp, elt, strlen(elt));
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1)]
+ *  Description: Returns the element of SET sp made of the length bytes at elt,
+ *  which need not be null terminated, without taking any lock as findElement does.
+ *  The calling thread's reader holds the epoch meanwhile, so nothing it reaches
+ *  is freed under it
+ */
+char *findBytes(SET *sp, char *elt, int length) {
+	assert((sp!=NULL) && (elt!=NULL) && (length >= 0));
+	unsigned hash = hashBytes(elt, length);
+	SHARD *sh = shardOf(sp, hash);
+	READER *rp = readerOf(sp);
+	unsigned seq;
+	TABLE *tp;
+	BLOOM *filter;
+	char *data;
+	__atomic_store_n(&rp->epoch, __atomic_load_n(&sp->epoch, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	do {
+		while((seq = __atomic_load_n(&sh->seq, __ATOMIC_ACQUIRE)) & 1)
+			sched_yield();  /* a writer is part way through a change */
+		tp = __atomic_load_n(&sh->table, __ATOMIC_ACQUIRE);
+		filter = __atomic_load_n(&tp->filter, __ATOMIC_ACQUIRE);
+		if(filter != NULL && !testBloom(filter, hash))
+			data = NULL;
+		else
+			data = probe(tp, elt, length, hash);
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	} while(__atomic_load_n(&sh->seq, __ATOMIC_RELAXED) != seq);
+	__atomic_store_n(&rp->epoch, 0, __ATOMIC_RELEASE);
+	return data;
+}
+
+
+/*
+ *  Time Complexity: O(n)
+ *  Description: Returns a copy of all elements in SET sp, holding every shard's
+ *  lock so the copy is a consistent snapshot
+ */
+char **getElements(SET *sp) {
+	assert(sp!=NULL);
+	TABLE *tp;
+	int i, j, k;
+	for(i = 0; i < SHARDS; i++)
+		pthread_mutex_lock(&sp->shards[i].lock);
+	char **copy = malloc(sizeof(char*)*numElements(sp));
+	assert(copy!=NULL);
+	k = 0;
+	for(i = 0; i < SHARDS; i++) {
+		tp = sp->shards[i].table;
+		for(j = 0; j < tp->length; j++) {
+			if(tp->slots[j].data != NULL) {
+				copy[k] = tp->slots[j].data;
+				k++;
+			}
+		}
+	}
+	for(i = SHARDS - 1; i >= 0; i--)
+		pthread_mutex_unlock(&sp->shards[i].lock);
+	return copy;
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1)]
+ *  Description: Starts a walk over SET sp at cursor cp, returning the first element
+ *  or NULL if there are none.  No copy of the set is made and no lock is taken, so
+ *  no thread may change the set until the walk is over
+ */
+char *setBegin(SET *sp, CURSOR *cp) {
+	assert((sp!=NULL) && (cp!=NULL));
+	cp->part = 0;
+	cp->index = -1;
+	return setNext(sp, cp);
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1)]
+ *  Description: Returns the element after cursor cp in SET sp and moves the cursor
+ *  to it, going on to the next shard at the end of each one, or returns NULL once
+ *  the walk is over
+ */
+char *setNext(SET *sp, CURSOR *cp) {
+	assert((sp!=NULL) && (cp!=NULL));
+	TABLE *tp;
+	while(cp->part < SHARDS) {
+		tp = sp->shards[cp->part].table;
+		while(++cp->index < tp->length) {
+			if(tp->slots[cp->index].data != NULL)
+				return tp->slots[cp->index].data;
+		}
+		cp->part++;
+		cp->index = -1;
+	}
+	return NULL;
+}
+
+
+/*
+ *  Time Complexity: O(n)
+ *  Description: Calls visit on every element of SET sp, passing arg along, while
+ *  holding every shard's lock so the walk sees a consistent snapshot.  visit must
+ *  not change the set
+ */
+void forEachElement(SET *sp, void (*visit)(char *elt, void *arg), void *arg) {
+	assert((sp!=NULL) && (visit!=NULL));
+	TABLE *tp;
+	int i, j;
+	for(i = 0; i < SHARDS; i++)
+		pthread_mutex_lock(&sp->shards[i].lock);
+	for(i = 0; i < SHARDS; i++) {
+		tp = sp->shards[i].table;
+		for(j = 0; j < tp->length; j++) {
+			if(tp->slots[j].data != NULL)
+				(*visit)(tp->slots[j].data, arg);
+		}
+	}
+	for(i = SHARDS - 1; i >= 0; i--)
+		pthread_mutex_unlock(&sp->shards[i].lock);
+}
+
+
+/*
+ *  Time Complexity: O(n/t) expected, with t threads
+ *  Description: Creates a set holding the distinct strings among the n in elts,
+ *  which are null terminated if lengths is NULL and otherwise lengths[i] bytes long,
+ *  splitting them evenly among nthreads threads that add their share through the
+ *  shard locks like any other writers
+ */
+SET *createSetFromArray(char *elts[], int lengths[], int n, int nthreads) {
+	assert((elts!=NULL) && (n >= 0));
+	pthread_t threads[MAX_THREADS];
+	SLICE slices[MAX_THREADS];
+	SET *sp = createSet(n/4);
+	int i, error;
+	nthreads = (nthreads < 1) ? 1 : (nthreads > MAX_THREADS) ? MAX_THREADS : nthreads;
+	for(i = 0; i < nthreads; i++) {
+		slices[i].sp = sp;
+		slices[i].elts = elts + (long) n * i / nthreads;
+		slices[i].lengths = (lengths != NULL) ? lengths + (long) n * i / nthreads : NULL;
+		slices[i].n = (long) n * (i + 1) / nthreads - (long) n * i / nthreads;
+		error = pthread_create(&threads[i], NULL, addSlice, &slices[i]);
+		if(error != 0) {  /* no thread to spare, so add the slice here */
+			addSlice(&slices[i]);
+			slices[i].sp = NULL;
+		}
+	}
+	for(i = 0; i < nthreads; i++) {
+		if(slices[i].sp != NULL)
+			pthread_join(threads[i], NULL);
+	}
+	return sp;
+}
+
+
+/*
+ *  Time Complexity: O(n) expected
+ *  Description: Thread body for createSetFromArray adding every element of a slice
+ */
+static void *addSlice(void *arg) {
+	SLICE *slp = arg;
+	int i;
+	for(i = 0; i < slp->n; i++)
+		insertBytes(slp->sp, slp->elts[i], (slp->lengths != NULL) ? slp->lengths[i] : strlen(slp->elts[i]));
+	return NULL;
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1) amortized]
+ *  Description: Returns the copy of the length bytes at elt held by SET sp, adding
+ *  one first if there is none
+ */
+static char *insertBytes(SET *sp, char *elt, int length) {
+	bool found;
+	int dist, index;
+	char *data;
+	SLOT slot;
+	slot.length = length;
+	slot.hash = hashBytes(elt, slot.length);
+	SHARD *sh = shardOf(sp, slot.hash);
+	lockShard(sh);
+	index = search(sh->table, elt, slot.hash, slot.length, &found, &dist);
+	if(found)
+		data = sh->table->slots[index].data;
+	else
+		data = add(sh, elt, slot, index, dist);
+	unlockShard(sh);
+	return data;
+}
+
+
+/*
+ *  Time Complexity: O(1)
+ *  Description: Takes the lock of shard sh and marks it as being changed
+ */
+static void lockShard(SHARD *sh) {
+	pthread_mutex_lock(&sh->lock);
+	__atomic_store_n(&sh->seq, sh->seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+
+/*
+ *  Time Complexity: O(1)
+ *  Description: Marks shard sh as no longer being changed and releases its lock
+ */
+static void unlockShard(SHARD *sh) {
+	__atomic_store_n(&sh->seq, sh->seq + 1, __ATOMIC_RELEASE);
+	pthread_mutex_unlock(&sh->lock);
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1)]
+ *  Description: Returns the element of table tp equal to the length bytes at elt, or
+ *  NULL.  Only reads the table, so may run while a writer is changing it; each slot
+ *  is copied before it is looked at, and a torn result is discarded by the caller.
+ *  A torn slot may pair one string with another's length, so the string is never
+ *  read past its null byte
+ */
+static char *probe(TABLE *tp, char *elt, int length, unsigned hash) {
+	int index = hash & (tp->length - 1);
+	int i;
+	SLOT slot;
+	for(i = 0; i < tp->length; i++) {
+		slot = tp->slots[index];
+		if(slot.data == NULL || ((index - slot.hash) & (tp->length - 1)) < i)
+			break;
+		if(slot.hash == hash && slot.length == length && strnlen(slot.data, length + 1) == length
+				&& memcmp(slot.data, elt, length) == 0)
+			return slot.data;
+		index = (index + 1) & (tp->length - 1);
+	}
+	return NULL;
+}
+
+
+/*
+ *  Time Complexity: O(n)
+ *  Description: Returns the smallest power of two table length that keeps
+ *  n elements at or below half full
+ */
+static int tableLength(int n) {
+	int length = MIN_LENGTH;
+	while(length < 2*n) {
+		assert(length <= INT_MAX/2);
+		length *= 2;
+	}
+	return length;
+}
+
+
+/*
+ *  Time Complexity: O(n)
+ *  Description: Returns a new empty table with the given length
+ */
+static TABLE *createTable(int length) {
+	TABLE *tp = malloc(sizeof(TABLE) + sizeof(SLOT)*length);
+	assert(tp!=NULL);
+	tp->next = NULL;
+	tp->length = length;
+	tp->filter = NULL;
+	int i;
+	for(i = 0; i < length; i++)
+		tp->slots[i].data = NULL;
+	return tp;
+}
+
+
+/*
+ *  Time Complexity: O(n)
+ *  Description: Moves every element of shard sh into a new table of the given
+ *  length and publishes it, retiring the old table for readers still probing it
+ *  and freeing whatever the shard retired before once no reader can see it
+ */
+static void rehash(SHARD *sh, int length) {
+	TABLE *old = sh->table;
+	TABLE *tp = createTable(length);
+	int i;
+	for(i = 0; i < old->length; i++) {
+		if(old->slots[i].data != NULL)
+			insert(tp, old->slots[i].hash & (length - 1), 0, old->slots[i]);
+	}
+	if(old->filter != NULL) {
+		tp->filter = createBloom(length);
+		fillFilter(tp);
+	}
+	tp->next = old;
+	__atomic_store_n(&sh->table, tp, __ATOMIC_RELEASE);
+	reclaim(sh);
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1) amortized]
+ *  Description: Adds a copy of elt, whose hash and length are in slot, to shard sh
+ *  at index and dist as found by search, growing the table first once more than
+ *  three quarters of its slots are full.  Returns the copy
+ */
+static char *add(SHARD *sh, char *elt, SLOT slot, int index, int dist) {
+	bool found;
+	if(4*(sh->count + 1) > 3*sh->table->length) {
+		rehash(sh, tableLength(sh->count + 1));
+		index = search(sh->table, elt, slot.hash, slot.length, &found, &dist);
+	}
+	slot.data = allocate(elt, slot.length);
+	insert(sh->table, index, dist, slot);
+	__atomic_store_n(&sh->count, sh->count + 1, __ATOMIC_RELAXED);
+	if(sh->table->filter != NULL) {
+		if(bloomFull(sh->table->filter))
+			fillFilter(sh->table);
+		else
+			addToBloom(sh->table->filter, slot.hash);
+	}
+	return slot.data;
+}
+
+
+/*
+ *  Time Complexity: O(n)
+ *  Description: Empties the filter of table tp and adds the cached hash of each of
+ *  its elements, clearing out the hashes of removed ones.  The filter has room for
+ *  one hash per slot and the table is never more than three quarters full, so a
+ *  quarter of its length more elements can be added before it must be refilled.
+ *  Readers testing the filter meanwhile see the shard's sequence number change and
+ *  test it again
+ */
+static void fillFilter(TABLE *tp) {
+	int i;
+	clearBloom(tp->filter);
+	for(i = 0; i < tp->length; i++) {
+		if(tp->slots[i].data != NULL)
+			addToBloom(tp->filter, tp->slots[i].hash);
+	}
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1) amortized]
+ *  Description: Removes the element at index from shard sh by shifting the rest of
+ *  its cluster back one slot, and shrinks the table once fewer than one eighth of
+ *  its slots are full.  The string itself is retired
+ */
+static void erase(SHARD *sh, int index) {
+	TABLE *tp = sh->table;
+	char *data = tp->slots[index].data;
+	int next = (index + 1) & (tp->length - 1);
+	/* stops at an empty slot or an element already home */
+	while(tp->slots[next].data != NULL && distance(tp, next) > 0) {
+		tp->slots[index] = tp->slots[next];
+		index = next;
+		next = (next + 1) & (tp->length - 1);
+	}
+	tp->slots[index].data = NULL;
+	__atomic_store_n(&sh->count, sh->count - 1, __ATOMIC_RELAXED);
+	retire(sh, data);
+	if(tp->length > MIN_LENGTH && 8*sh->count < tp->length)
+		rehash(sh, tableLength(sh->count));
+}
+
+
+/*
+ *  Time Complexity: O(n)
+ *  Description: Returns a null terminated copy of s, of the given length.  Each
+ *  string has its own allocation so it can be freed once removed and retired
+ */
+static char *allocate(char *s, int length) {
+	char *copy = malloc(length + 1);
+	assert(copy!=NULL);
+	memcpy(copy, s, length);
+	copy[length] = '\0';
+	return copy;
+}
+
+
+/*
+ *  Time Complexity: O(r) [expected O(1) amortized], with r readers
+ *  Description: Adds s, just removed from shard sh, to the strings it has retired,
+ *  trying to free some after every RETIRE_BATCH more
+ */
+static void retire(SHARD *sh, char *s) {
+	if(sh->numRetired == sh->maxRetired) {
+		sh->maxRetired = (sh->maxRetired > 0) ? 2*sh->maxRetired : RETIRE_BATCH;
+		sh->retired = realloc(sh->retired, sizeof(char*)*sh->maxRetired);
+		assert(sh->retired!=NULL);
+	}
+	sh->retired[sh->numRetired++] = s;
+	if(sh->numRetired >= sh->reclaimAt)
+		reclaim(sh);
+}
+
+
+/*
+ *  Time Complexity: O(n + r), with r readers
+ *  Description: Frees what shard sh stamped last time if every reader now inside
+ *  entered at or after its stamp, then stamps everything retired since, freeing it
+ *  too if no reader entered before this newest stamp.  Whatever cannot be freed yet
+ *  is left for a later try.  Only called with the shard's lock held
+ */
+static void reclaim(SHARD *sh) {
+	unsigned long epoch, oldest;
+	if(sh->table->next == NULL && sh->numRetired == 0)
+		return;
+	epoch = advance(sh->set, &oldest);
+	if(sh->stamp <= oldest)
+		freeStamped(sh);
+	if(sh->stamped == NULL && sh->numStamped == 0) {
+		sh->stamped = sh->table->next;
+		sh->table->next = NULL;
+		sh->numStamped = sh->numRetired;
+		sh->stamp = epoch;
+		if(epoch <= oldest)
+			freeStamped(sh);
+	}
+	sh->reclaimAt = sh->numRetired + RETIRE_BATCH;
+}
+
+
+/*
+ *  Time Complexity: O(n)
+ *  Description: Frees the stamped tables and strings of shard sh, moving the strings
+ *  retired since to the front
+ */
+static void freeStamped(SHARD *sh) {
+	TABLE *tp;
+	int i;
+	while(sh->stamped != NULL) {
+		tp = sh->stamped;
+		sh->stamped = tp->next;
+		if(tp->filter != NULL)
+			destroyBloom(tp->filter);
+		free(tp);
+	}
+	if(sh->numStamped > 0) {
+		for(i = 0; i < sh->numStamped; i++)
+			free(sh->retired[i]);
+		memmove(sh->retired, sh->retired + sh->numStamped, sizeof(char*)*(sh->numRetired - sh->numStamped));
+		sh->numRetired -= sh->numStamped;
+		sh->numStamped = 0;
+	}
+}
+
+
+/*
+ *  Time Complexity: O(r), with r readers
+ *  Description: Advances the epoch of SET sp and returns it, and through oldest the
+ *  earliest epoch any reader now inside findElement entered at, or ULONG_MAX if
+ *  there are none.  Anything unlinked before the call is out of reach of a reader
+ *  that entered at or after the returned epoch: it sees the epoch only after its
+ *  own fence, and so sees the unlinking too
+ */
+static unsigned long advance(SET *sp, unsigned long *oldest) {
+	unsigned long epoch = __atomic_add_fetch(&sp->epoch, 1, __ATOMIC_SEQ_CST);
+	unsigned long seen;
+	READER *rp;
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	*oldest = ULONG_MAX;
+	for(rp = __atomic_load_n(&sp->readers, __ATOMIC_ACQUIRE); rp != NULL; rp = rp->next) {
+		seen = __atomic_load_n(&rp->epoch, __ATOMIC_ACQUIRE);
+		if(seen != 0 && seen < *oldest)
+			*oldest = seen;
+	}
+	return epoch;
+}
+
+
+/*
+ *  Time Complexity: O(r), with r readers [expected O(1)]
+ *  Description: Returns the calling thread's reader for SET sp, adding one to the
+ *  front of the set's list without a lock the first time the thread looks up an
+ *  element in it
+ */
+static READER *readerOf(SET *sp) {
+	READER *rp;
+	pthread_t self;
+	if(lastSet == sp && lastId == sp->id)
+		return lastReader;
+	self = pthread_self();
+	for(rp = __atomic_load_n(&sp->readers, __ATOMIC_ACQUIRE); rp != NULL; rp = rp->next) {
+		if(pthread_equal(rp->owner, self))
+			break;
+	}
+	if(rp == NULL) {
+		rp = aligned_alloc(64, sizeof(READER));
+		assert(rp!=NULL);
+		rp->owner = self;
+		rp->epoch = 0;
+		rp->next = __atomic_load_n(&sp->readers, __ATOMIC_RELAXED);
+		while(!__atomic_compare_exchange_n(&sp->readers, &rp->next, rp, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+			;
+	}
+	lastSet = sp;
+	lastId = sp->id;
+	lastReader = rp;
+	return rp;
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1)]
+ *  Description: Places slot at index of table tp, which is dist slots from its home,
+ *  using Robin Hood hashing: whenever the element being placed is farther from home
+ *  than the one occupying a slot, they trade places and the displaced element moves on
+ */
+static void insert(TABLE *tp, int index, int dist, SLOT slot) {
+	SLOT temp;
+	int tempDist;
+	while(tp->slots[index].data != NULL) {
+		tempDist = distance(tp, index);
+		if(tempDist < dist) {
+			temp = tp->slots[index];
+			tp->slots[index] = slot;
+			slot = temp;
+			dist = tempDist;
+		}
+		index = (index + 1) & (tp->length - 1);
+		dist++;
+	}
+	tp->slots[index] = slot;
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1)]
+ *  Description: Locates a specific element in table tp using linear probing,
+ *  stopping early once a slot holds an element closer to its home than elt would be.
+ *  Slots are only compared with memcmp when their cached hash and length match,
+ *  so elt need not be null terminated.
+ *  If the element is not found, returns the slot where it belongs and its distance
+ *  from home through dist.  Only called with the shard's lock held
+ */
+static int search(TABLE *tp, char *elt, unsigned hash, int length, bool *found, int *dist) {
+	int index = hash & (tp->length - 1);
+	int i = 0;
+	while(tp->slots[index].data != NULL && distance(tp, index) >= i) {
+		if(tp->slots[index].hash == hash && tp->slots[index].length == length
+				&& memcmp(tp->slots[index].data, elt, length) == 0) {
+			*found = true; /* element was found, returns location */
+			*dist = i;
+			return index;
+		}
+		index = (index + 1) & (tp->length - 1);
+		i++;
+	}
+	*found = false; /* element not found, returns the slot it would be placed in */
+	*dist = i;
+	return index;
+}
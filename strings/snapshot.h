@@ -0,0 +1,20 @@
+/*
+ * File:        snapshot.h
+ *
+ * Description: This file contains the public function declarations for
+ *              writing a set of strings to a file and mapping it back in.
+ *              Only the table in table.c implements them, so a program
+ *              that uses them must be linked with it rather than with
+ *              swiss.c or shard.c.
+ */
+
+# ifndef SNAPSHOT_H
+# define SNAPSHOT_H
+
+# include "set.h"
+
+int saveSet(SET *sp, char *name);
+
+SET *loadSet(char *name);
+
+# endif /* SNAPSHOT_H */
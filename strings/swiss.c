@@ -0,0 +1,489 @@
+/*
+ * Description: Set ADT for strings using open addressing with a separate array of
+ * control bytes, one per slot.  A full slot's control byte holds seven bits of the
+ * element's hash, so a group of sixteen slots can be checked against a key with a
+ * single SSE2 comparison and only slots whose bits match are compared with the key.
+ * Link with this file instead of table.c to use it behind the same set.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+#include <limits.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "set.h"
+#include "hash.h"
+#include "bloom.h"
+
+#define GROUP 16
+#define EMPTY 0x80
+#define DELETED 0xFE
+
+static unsigned match(unsigned char *ctrl, unsigned char byte);
+static int search(SET *sp, char *elt, int length, unsigned hash, bool *found);
+static int tableLength(int n);
+static void rehash(SET *sp, int length);
+static char *add(SET *sp, char *elt, int length, unsigned hash, int index);
+static void erase(SET *sp, int index);
+static void buildFilter(SET *sp);
+
+/* ctrl is EMPTY, DELETED, or the low seven bits of a full slot's hash, and filter
+   holds the hash of every element, and of some since removed, or is NULL */
+struct set{
+	char **data;
+	unsigned char *ctrl;
+	int count;
+	int deleted;
+	int length;
+	BLOOM *filter;
+};
+
+
+/*
+ * Time Complexity: O(n)
+ * Description: Creates a new set, maxElts is only a hint since the table grows as needed
+ */
+SET *createSet(int maxElts) {
+	SET *sp = malloc(sizeof(SET));
+	assert(sp!=NULL);
+	sp->length = tableLength(maxElts);
+	sp->count = 0;
+	sp->deleted = 0;
+	sp->filter = NULL;
+	sp->data = malloc(sizeof(char*)*sp->length);
+	assert(sp->data!=NULL);
+	sp->ctrl = malloc(sizeof(unsigned char)*sp->length);
+	assert(sp->ctrl!=NULL);
+	memset(sp->ctrl, EMPTY, sp->length);
+	return sp;
+}
+
+
+/*
+ *  Time Complexity: O(n)
+ *  Description: Frees all memory associated with SET sp
+ */
+void destroySet(SET *sp) {
+	assert(sp!=NULL);
+	int i;
+	for(i = 0; i < sp->length; i++) {
+		if(sp->ctrl[i] < EMPTY)
+			free(sp->data[i]);
+	}
+	free(sp->data);
+	free(sp->ctrl);
+	if(sp->filter != NULL)
+		destroyBloom(sp->filter);
+	free(sp);
+}
+
+
+/*
+ *  Time Complexity: O(n) to turn on, O(1) to turn off
+ *  Description: Turns the Bloom filter in front of SET sp on or off.  While it is on,
+ *  looking up or removing a string the filter has never seen returns without
+ *  probing the table, which helps when most strings looked up are absent
+ */
+void setFilter(SET *sp, int on) {
+	assert(sp!=NULL);
+	if(sp->filter != NULL) {
+		destroyBloom(sp->filter);
+		sp->filter = NULL;
+	}
+	if(on)
+		buildFilter(sp);
+}
+
+
+/*
+ *  Time Complexity: O(1)
+ *  Description: Returns the number of elements in SET sp
+ */
+int numElements(SET *sp) {
+	assert(sp!=NULL);
+	return sp->count;
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1) amortized]
+ *  Description: Adds new element to hashed location in SET sp
+ */
+void addElement(SET *sp, char *elt) {
+	assert((sp!=NULL) && (elt!=NULL));
+	addBytes(sp, elt, strlen(elt));
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1) amortized]
+ *  Description: Adds the length bytes at elt, which need not be null terminated,
+ *  to SET sp as a string
+ */
+void addBytes(SET *sp, char *elt, int length) {
+	assert((sp!=NULL) && (elt!=NULL) && (length >= 0));
+	bool found;
+	unsigned hash = hashBytes(elt, length);
+	int index = search(sp, elt, length, hash, &found);
+	if(!found)
+		add(sp, elt, length, hash, index);
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1) amortized]
+ *  Description: Returns the copy of elt held by SET sp, adding one first if there
+ *  is none, with a single search of the table
+ */
+char *insertOrGet(SET *sp, char *elt) {
+	assert((sp!=NULL) && (elt!=NULL));
+	bool found;
+	int length = strlen(elt);
+	unsigned hash = hashBytes(elt, length);
+	int index = search(sp, elt, length, hash, &found);
+	if(found)
+		return sp->data[index];
+	return add(sp, elt, length, hash, index);
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1) amortized]
+ *  Description: Removes specified element from set SP
+ */
+void removeElement(SET *sp, char *elt) {
+	assert((sp!=NULL) && (elt!=NULL));
+	removeBytes(sp, elt, strlen(elt));
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1) amortized]
+ *  Description: Removes the string made of the length bytes at elt from SET sp
+ */
+void removeBytes(SET *sp, char *elt, int length) {
+	assert((sp!=NULL) && (elt!=NULL) && (length >= 0) && (sp->count > 0));
+	bool found;
+	unsigned hash = hashBytes(elt, length);
+	if(sp->filter != NULL && !testBloom(sp->filter, hash))
+		return;
+	int index = search(sp, elt, length, hash, &found);
+	if(found)
+		erase(sp, index);
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1) amortized]
+ *  Description: Removes elt from SET sp if it is present and adds it otherwise, with
+ *  a single search of the table.  Returns nonzero if elt is in the set afterwards
+ */
+int toggleElement(SET *sp, char *elt) {
+	assert((sp!=NULL) && (elt!=NULL));
+	return toggleBytes(sp, elt, strlen(elt));
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1) amortized]
+ *  Description: Toggles the string made of the length bytes at elt in SET sp as
+ *  toggleElement does
+ */
+int toggleBytes(SET *sp, char *elt, int length) {
+	assert((sp!=NULL) && (elt!=NULL) && (length >= 0));
+	bool found;
+	unsigned hash = hashBytes(elt, length);
+	int index = search(sp, elt, length, hash, &found);
+	if(found) {
+		erase(sp, index);
+		return 0;
+	}
+	add(sp, elt, length, hash, index);
+	return 1;
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1)]
+ *  Description: Returns location of speficied element in SET sp
+ */
+char *findElement(SET *sp, char *elt) {
+	assert((sp!=NULL) && (elt!=NULL));
+	return findBytes(sp, elt, strlen(elt));
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1)]
+ *  Description: Returns the element of SET sp made of the length bytes at elt,
+ *  which need not be null terminated, or NULL if there is none
+ */
+char *findBytes(SET *sp, char *elt, int length) {
+	assert((sp!=NULL) && (elt!=NULL) && (length >= 0));
+	bool found;
+	unsigned hash = hashBytes(elt, length);
+	if(sp->filter != NULL && !testBloom(sp->filter, hash))
+		return NULL;
+	int index = search(sp, elt, length, hash, &found);
+	if(found)
+		return sp->data[index];
+	return NULL;
+}
+
+
+/*
+ *  Time Complexity: O(n)
+ *  Description: Returns a copy of all elements in SET sp
+ */
+char **getElements(SET *sp) {
+	assert(sp!=NULL);
+	char **copy = malloc(sizeof(char*)*sp->count);
+	assert(copy!=NULL);
+	int i;
+	int j = 0;
+	for(i = 0; i < sp->length; i++) {
+		if(sp->ctrl[i] < EMPTY) {
+			copy[j] = sp->data[i];
+			j++;
+		}
+	}
+	return copy;
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1)]
+ *  Description: Starts a walk over SET sp at cursor cp, returning the first element
+ *  or NULL if there are none.  No copy of the set is made
+ */
+char *setBegin(SET *sp, CURSOR *cp) {
+	assert((sp!=NULL) && (cp!=NULL));
+	cp->part = 0;
+	cp->index = -1;
+	return setNext(sp, cp);
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1)]
+ *  Description: Returns the element after cursor cp in SET sp and moves the cursor
+ *  to it, or returns NULL once the walk is over
+ */
+char *setNext(SET *sp, CURSOR *cp) {
+	assert((sp!=NULL) && (cp!=NULL));
+	while(++cp->index < sp->length) {
+		if(sp->ctrl[cp->index] < EMPTY)
+			return sp->data[cp->index];
+	}
+	cp->index = sp->length;
+	return NULL;
+}
+
+
+/*
+ *  Time Complexity: O(n)
+ *  Description: Calls visit on every element of SET sp, passing arg along
+ */
+void forEachElement(SET *sp, void (*visit)(char *elt, void *arg), void *arg) {
+	assert((sp!=NULL) && (visit!=NULL));
+	int i;
+	for(i = 0; i < sp->length; i++) {
+		if(sp->ctrl[i] < EMPTY)
+			(*visit)(sp->data[i], arg);
+	}
+}
+
+
+/*
+ *  Time Complexity: O(n) expected
+ *  Description: Creates a set holding the distinct strings among the n in elts,
+ *  which are null terminated if lengths is NULL and otherwise lengths[i] bytes
+ *  long.  This table is built by one thread, so nthreads is ignored
+ */
+SET *createSetFromArray(char *elts[], int lengths[], int n, int nthreads) {
+	assert((elts!=NULL) && (n >= 0));
+	SET *sp = createSet(n/4);
+	int i;
+	for(i = 0; i < n; i++)
+		addBytes(sp, elts[i], (lengths != NULL) ? lengths[i] : strlen(elts[i]));
+	return sp;
+}
+
+
+/*
+ *  Time Complexity: O(1)
+ *  Description: Returns a bit mask of the slots in the group starting at ctrl
+ *  whose control byte equals byte
+ */
+static unsigned match(unsigned char *ctrl, unsigned char byte) {
+#ifdef __SSE2__
+	__m128i group = _mm_loadu_si128((__m128i *) ctrl);
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(byte)));
+#else
+	unsigned mask = 0;
+	int i;
+	for(i = 0; i < GROUP; i++) {
+		if(ctrl[i] == byte)
+			mask |= 1u << i;
+	}
+	return mask;
+#endif
+}
+
+
+/*
+ *  Time Complexity: O(n)
+ *  Description: Returns the smallest power of two table length, and at least one
+ *  group, that keeps n elements at or below half full
+ */
+static int tableLength(int n) {
+	int length = GROUP;
+	while(length < 2*n) {
+		assert(length <= INT_MAX/2);
+		length *= 2;
+	}
+	return length;
+}
+
+
+/*
+ *  Time Complexity: O(n)
+ *  Description: Moves every element of SET sp into a new table of the given length,
+ *  discarding deleted slots along the way
+ */
+static void rehash(SET *sp, int length) {
+	char **data = sp->data;
+	unsigned char *ctrl = sp->ctrl;
+	int oldLength = sp->length;
+	bool found;
+	int i, index, size;
+	unsigned hash;
+	sp->length = length;
+	sp->deleted = 0;
+	sp->data = malloc(sizeof(char*)*length);
+	assert(sp->data!=NULL);
+	sp->ctrl = malloc(sizeof(unsigned char)*length);
+	assert(sp->ctrl!=NULL);
+	memset(sp->ctrl, EMPTY, length);
+	for(i = 0; i < oldLength; i++) {
+		if(ctrl[i] < EMPTY) {
+			size = strlen(data[i]);
+			hash = hashBytes(data[i], size);
+			index = search(sp, data[i], size, hash, &found);
+			sp->data[index] = data[i];
+			sp->ctrl[index] = hash & 0x7F;
+		}
+	}
+	free(data);
+	free(ctrl);
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1) amortized]
+ *  Description: Adds a copy of elt at index as found by search, growing the table
+ *  first once more than seven eighths of its slots are full or deleted.  Returns
+ *  the copy
+ */
+static char *add(SET *sp, char *elt, int length, unsigned hash, int index) {
+	bool found;
+	if(sp->ctrl[index] == EMPTY && 8*(sp->count + sp->deleted + 1) > 7*sp->length) {
+		rehash(sp, tableLength(sp->count + 1));
+		index = search(sp, elt, length, hash, &found);
+	}
+	if(sp->ctrl[index] == DELETED)
+		sp->deleted--;
+	sp->data[index] = strndup(elt, length);
+	assert(sp->data[index]!=NULL);
+	sp->ctrl[index] = hash & 0x7F;
+	sp->count++;
+	if(sp->filter != NULL) {
+		if(bloomFull(sp->filter))
+			buildFilter(sp);
+		else
+			addToBloom(sp->filter, hash);
+	}
+	return sp->data[index];
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1) amortized]
+ *  Description: Removes the element at index, shrinking the table once fewer
+ *  than one eighth of its slots are full
+ */
+static void erase(SET *sp, int index) {
+	free(sp->data[index]);
+	/* a group that still has an empty slot has never been probed past,
+	   so the slot can be emptied instead of marked deleted */
+	if(match(sp->ctrl + index - index % GROUP, EMPTY) != 0)
+		sp->ctrl[index] = EMPTY;
+	else {
+		sp->ctrl[index] = DELETED;
+		sp->deleted++;
+	}
+	sp->count--;
+	if(sp->length > GROUP && 8*sp->count < sp->length)
+		rehash(sp, tableLength(sp->count));
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1)]
+ *  Description: Locates a specific element in the hash table one group at a time,
+ *  visiting groups in triangular order from the home group.  Only slots whose
+ *  control byte matches the hash are compared with the length bytes of elt, which
+ *  need not be null terminated, and the search ends at the first
+ *  group with an empty slot.  If the element is not found, returns the first
+ *  deleted or empty slot seen, where it should be added
+ */
+static int search(SET *sp, char *elt, int length, unsigned hash, bool *found) {
+	int groups = sp->length / GROUP;
+	int group = (hash >> 7) & (groups - 1);
+	int deleted = -1;
+	unsigned mask;
+	int i, index;
+	for(i = 1; i <= groups; i++) {
+		unsigned char *ctrl = sp->ctrl + group*GROUP;
+		for(mask = match(ctrl, hash & 0x7F); mask != 0; mask &= mask - 1) {
+			index = group*GROUP + __builtin_ctz(mask);
+			if(strnlen(sp->data[index], length + 1) == length && memcmp(sp->data[index], elt, length) == 0) {
+				*found = true; /* element was found, returns location */
+				return index;
+			}
+		}
+		if(deleted == -1 && sp->deleted > 0 && (mask = match(ctrl, DELETED)) != 0)
+			deleted = group*GROUP + __builtin_ctz(mask);  /* saves first deleted slot */
+		if((mask = match(ctrl, EMPTY)) != 0) {
+			*found = false;  /* element was not found, returns first free location */
+			if(deleted > -1)
+				return deleted;
+			return group*GROUP + __builtin_ctz(mask);
+		}
+		group = (group + i) & (groups - 1);
+	}
+	*found = false;
+	return deleted;
+}
+
+
+/*
+ *  Time Complexity: O(n)
+ *  Description: Replaces the filter of SET sp with one built from the hashes of its
+ *  elements, with room for as many again before it fills up.  Removals leave their
+ *  hashes in the filter, and this is how they are cleared out
+ */
+static void buildFilter(SET *sp) {
+	int i;
+	if(sp->filter != NULL)
+		destroyBloom(sp->filter);
+	sp->filter = createBloom(2*sp->count);
+	for(i = 0; i < sp->length; i++) {
+		if(sp->ctrl[i] < EMPTY)
+			addToBloom(sp->filter, hashBytes(sp->data[i], strlen(sp->data[i])));
+	}
+}
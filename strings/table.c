@@ -3,56 +3,193 @@
 #include <stdbool.h>
 #include <string.h>
 #include <assert.h>
+#include <limits.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "set.h"
+#include "snapshot.h"
+#include "hash.h"
+#include "bloom.h"
 
-static unsigned strhash(char *s);
-static int search(SET *sp, char *elt, bool *found);
+#define MIN_LENGTH 8
+#define BLOCK_SIZE 65536
+#define MAX_THREADS 256
+#define MAGIC "STRSET1"
 
+/* Each slot caches its element's full hash and string length, data is NULL if empty */
+typedef struct slot {
+	char *data;
+	unsigned hash;
+	int length;
+} SLOT;
+
+/* Strings are bump allocated out of a list of large blocks */
+typedef struct block {
+	struct block *next;
+	int used;
+	int size;
+	char text[];
+} BLOCK;
+
+/* A snapshot file is this header, then the slots of the table with each string's
+   offset from the start of the file in place of its address, then the strings
+   themselves, null terminated.  check is the hash of the magic string, so a file
+   written under another hash seed is refused */
+typedef struct header {
+	char magic[8];
+	unsigned check;
+	int count;
+	int length;
+	long size;
+} HEADER;
+
+/* Home slot of a hash, taken from its top bits so that the table splits into
+   contiguous ranges by hash prefix */
+#define home(sp, hash) ((hash) >> (sp)->shift)
+#define rotate(hash, bits) (((bits) & 31) == 0 ? (hash) : ((hash) << ((bits) & 31)) | ((hash) >> (32 - ((bits) & 31))))
+
+/* String of the element in slot i, whose data is an offset from base while the
+   slots are still those of a mapped snapshot */
+#define text(sp, i) ((sp)->base == NULL ? (sp)->slots[i].data : (sp)->base + (size_t) (sp)->slots[i].data)
+
+/* Distance of the element in slot i from its home slot */
+#define distance(sp, i) (((i) - home(sp, (sp)->slots[i].hash)) & ((sp)->length - 1))
+
+static int search(SET *sp, char *elt, unsigned hash, int length, bool *found, int *dist);
+static void insert(SET *sp, int index, int dist, SLOT slot);
+static char *add(SET *sp, char *elt, SLOT slot, int index, int dist);
+static void erase(SET *sp, int index);
+static int tableLength(int n);
+static int tableShift(int length);
+static void rehash(SET *sp, int length);
+static char *allocate(SET *sp, char *s, int length);
+static void compact(SET *sp);
+static bool checkSlots(char *mapping, size_t size);
+static void thaw(SET *sp);
+static void buildFilter(SET *sp);
+
+/* State shared by the threads of createSetFromArray: keys holds every element with
+   its hash and length, grouped by partition once scattered, and each partition is
+   deduplicated into a set of its own before being placed in its range of the final
+   table.  Elements pushed out of the end of a range are spilled and placed last.
+   Since every key in a partition shares its top bits, hashes are rotated by bits
+   while in a partition's set so that its homes still spread over its whole table */
+typedef struct build {
+	char **elts;
+	int *lengths;
+	int n;
+	int nthreads;
+	int partitions;
+	int bits;
+	SLOT *keys;
+	SLOT *sorted;
+	int *counts;
+	SET **parts;
+	SET *sp;
+	SLOT **spill;
+	int *spilled;
+} BUILD;
+
+/* One thread's share of a build */
+typedef struct worker {
+	BUILD *bp;
+	int id;
+} WORKER;
+
+static void run(BUILD *bp, void *(*phase)(void *));
+static void *hashKeys(void *arg);
+static void *scatterKeys(void *arg);
+static void *dedupKeys(void *arg);
+static void *placeKeys(void *arg);
+static bool insertRange(SET *sp, int index, int end, SLOT *slot);
+
+/* live and dead count the bytes of block space held by present and removed strings.
+   A set loaded from a snapshot keeps the file mapped at mapping, and base is the
+   mapping while slots still points into it, or NULL once they have been copied out.
+   filter holds the hash of every element, and of some since removed, or is NULL */
 struct set{
-	char **data;
-	char *flag;
+	SLOT *slots;
 	int count;
 	int length;
+	int shift;
+	BLOCK *blocks;
+	long live;
+	long dead;
+	char *base;
+	void *mapping;
+	size_t size;
+	BLOOM *filter;
 };
 
 
 /*
  * Time Complexity: O(n)
- * Description: Creates a new set
+ * Description: Creates a new set, maxElts is only a hint since the table grows as needed
  */
 SET *createSet(int maxElts) {
 	SET *sp = malloc(sizeof(SET));
 	assert(sp!=NULL);
-	sp->length = maxElts;
+	sp->length = tableLength(maxElts);
+	sp->shift = tableShift(sp->length);
 	sp->count = 0;
-	sp->data = malloc(sizeof(char*)*maxElts);
-	assert(sp->data!=NULL);
-	sp->flag = malloc(sizeof(char)*maxElts);
-	assert(sp->flag!=NULL);
+	sp->blocks = NULL;
+	sp->live = 0;
+	sp->dead = 0;
+	sp->base = NULL;
+	sp->mapping = NULL;
+	sp->size = 0;
+	sp->filter = NULL;
+	sp->slots = malloc(sizeof(SLOT)*sp->length);
+	assert(sp->slots!=NULL);
 	int i;
-	for(i = 0; i < maxElts; i++)
-		sp->flag[i] = 'E';
+	for(i = 0; i < sp->length; i++)
+		sp->slots[i].data = NULL;
 	return sp;
 }
 
 
 /*
- *  Time Complexity: O(n)
+ *  Time Complexity: O(1) per block
  *  Description: Frees all memory associated with SET sp
  */
 void destroySet(SET *sp) {
 	assert(sp!=NULL);
-	int i;
-	for(i = 0; i < sp->length; i++) {
-		if(sp->flag[i] == 'F')
-			free(sp->data[i]);
+	BLOCK *bp;
+	while(sp->blocks != NULL) {
+		bp = sp->blocks;
+		sp->blocks = bp->next;
+		free(bp);
 	}
-	free(sp->data);
-	free(sp->flag);
+	if(sp->base == NULL)
+		free(sp->slots);
+	if(sp->mapping != NULL)
+		munmap(sp->mapping, sp->size);
+	if(sp->filter != NULL)
+		destroyBloom(sp->filter);
 	free(sp);
 }
 
 
+/*
+ *  Time Complexity: O(n) to turn on, O(1) to turn off
+ *  Description: Turns the Bloom filter in front of SET sp on or off.  While it is on,
+ *  looking up or removing a string the filter has never seen returns without
+ *  probing the table, which helps when most strings looked up are absent
+ */
+void setFilter(SET *sp, int on) {
+	assert(sp!=NULL);
+	if(sp->filter != NULL) {
+		destroyBloom(sp->filter);
+		sp->filter = NULL;
+	}
+	if(on)
+		buildFilter(sp);
+}
+
+
 /*
  *  Time Complexity: O(1)
  *  Description: Returns the number of elements in SET sp
@@ -64,54 +201,151 @@ int numElements(SET *sp) {
 
 
 /*
- *  Time Complexity: O(n) [expected O(1)]
+ *  Time Complexity: O(n) [expected O(1) amortized]
  *  Description: Adds new element to hashed location in SET sp
  */
 void addElement(SET *sp, char *elt) {
-	assert((sp!=NULL) && (elt!=NULL) && (sp->count < sp->length));
+	assert((sp!=NULL) && (elt!=NULL));
+	addBytes(sp, elt, strlen(elt));
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1) amortized]
+ *  Description: Adds the length bytes at elt, which need not be null terminated,
+ *  to SET sp as a string
+ */
+void addBytes(SET *sp, char *elt, int length) {
+	assert((sp!=NULL) && (elt!=NULL) && (length >= 0));
+	thaw(sp);
 	bool found;
-	int index = search(sp, elt, &found);
-	if((!found) && index > -1) {
-		sp->data[index] = strdup(elt);
-		sp->flag[index] = 'F';
-		sp->count++;
-	}
+	int dist;
+	SLOT slot;
+	slot.length = length;
+	slot.hash = hashBytes(elt, slot.length);
+	int index = search(sp, elt, slot.hash, slot.length, &found, &dist);
+	if(!found)
+		add(sp, elt, slot, index, dist);
 }
 
 
 /*
- *  Time Complexity: O(n) [expected O(1)]
+ *  Time Complexity: O(n) [expected O(1) amortized]
+ *  Description: Returns the copy of elt held by SET sp, adding one first if there
+ *  is none, with a single search of the table.  The copy stays valid only until
+ *  the next element is removed
+ */
+char *insertOrGet(SET *sp, char *elt) {
+	assert((sp!=NULL) && (elt!=NULL));
+	thaw(sp);
+	bool found;
+	int dist;
+	SLOT slot;
+	slot.length = strlen(elt);
+	slot.hash = hashBytes(elt, slot.length);
+	int index = search(sp, elt, slot.hash, slot.length, &found, &dist);
+	if(found)
+		return sp->slots[index].data;
+	return add(sp, elt, slot, index, dist);
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1) amortized]
  *  Description: Removes specified element from set SP
  */
 void removeElement(SET *sp, char *elt) {
-	assert((sp!=NULL) && (elt!=NULL) && (sp->count > 0));
+	assert((sp!=NULL) && (elt!=NULL));
+	removeBytes(sp, elt, strlen(elt));
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1) amortized]
+ *  Description: Removes the string made of the length bytes at elt from SET sp
+ */
+void removeBytes(SET *sp, char *elt, int length) {
+	assert((sp!=NULL) && (elt!=NULL) && (length >= 0) && (sp->count > 0));
+	thaw(sp);
+	bool found;
+	int dist;
+	unsigned hash = hashBytes(elt, length);
+	if(sp->filter != NULL && !testBloom(sp->filter, hash))
+		return;
+	int index = search(sp, elt, hash, length, &found, &dist);
+	if(found)
+		erase(sp, index);
+} 
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1) amortized]
+ *  Description: Removes elt from SET sp if it is present and adds it otherwise, with
+ *  a single search of the table.  Returns nonzero if elt is in the set afterwards
+ */
+int toggleElement(SET *sp, char *elt) {
+	assert((sp!=NULL) && (elt!=NULL));
+	return toggleBytes(sp, elt, strlen(elt));
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1) amortized]
+ *  Description: Toggles the string made of the length bytes at elt in SET sp as
+ *  toggleElement does
+ */
+int toggleBytes(SET *sp, char *elt, int length) {
+	assert((sp!=NULL) && (elt!=NULL) && (length >= 0));
+	thaw(sp);
 	bool found;
-	int index = search(sp, elt, &found);
+	int dist;
+	SLOT slot;
+	slot.length = length;
+	slot.hash = hashBytes(elt, slot.length);
+	int index = search(sp, elt, slot.hash, slot.length, &found, &dist);
 	if(found) {
-		free(sp->data[index]);
-		sp->flag[index] = 'D';
-		sp->count--;
+		erase(sp, index);
+		return 0;
 	}
-} 
+	add(sp, elt, slot, index, dist);
+	return 1;
+}
 
 
 /*
  *  Time Complexity: O(n) [expected O(1)]
- *  Description: Returns location of speficied element in SET sp
+ *  Description: Returns location of speficied element in SET sp, which stays
+ *  valid only until the next element is removed
  */
 char *findElement(SET *sp, char *elt) {
-	assert((sp!=NULL) && (elt!=NULL) && (sp->count >= 0));
+	assert((sp!=NULL) && (elt!=NULL));
+	return findBytes(sp, elt, strlen(elt));
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1)]
+ *  Description: Returns the element of SET sp made of the length bytes at elt,
+ *  which need not be null terminated, or NULL if there is none
+ */
+char *findBytes(SET *sp, char *elt, int length) {
+	assert((sp!=NULL) && (elt!=NULL) && (length >= 0) && (sp->count >= 0));
 	bool found;
-	int index = search(sp, elt, &found);
+	int dist;
+	unsigned hash = hashBytes(elt, length);
+	if(sp->filter != NULL && !testBloom(sp->filter, hash))
+		return NULL;
+	int index = search(sp, elt, hash, length, &found, &dist);
 	if(found)
-		return sp->data[index];
+		return text(sp, index);
 	return NULL;
 }
 
 
 /*
  *  Time Complexity: O(n)
- *  Description: Returns a copy of all elements in SET sp
+ *  Description: Returns a copy of all elements in SET sp, which stay valid
+ *  only until the next element is removed
  */
 char **getElements(SET *sp) {
 	assert(sp!=NULL);
@@ -119,8 +353,8 @@ char **getElements(SET *sp) {
 	int i; 
 	int j = 0;
 	for(i = 0; i < sp->length; i++) {
-		if(sp->flag[i] == 'F') {
-			copy[j] = sp->data[i];
+		if(sp->slots[i].data != NULL) {
+			copy[j] = text(sp, i);
 			j++;
 		}
 	}
@@ -129,45 +363,659 @@ char **getElements(SET *sp) {
 
 
 /*
- *  Time Complexity: O(n)
- *  Description: simple hash function for mapping elements to location in table
+ *  Time Complexity: O(n) [expected O(1)]
+ *  Description: Starts a walk over SET sp at cursor cp, returning the first element
+ *  or NULL if there are none.  No copy of the set is made
  */
-unsigned strhash(char *s) {
-	unsigned hash = 0;
-	while(*s != '\0')
-		hash = 31*hash + *s++;
-	return hash;
+char *setBegin(SET *sp, CURSOR *cp) {
+	assert((sp!=NULL) && (cp!=NULL));
+	cp->part = 0;
+	cp->index = -1;
+	return setNext(sp, cp);
 }
 
 
 /*
  *  Time Complexity: O(n) [expected O(1)]
- *  Description: Locates a specific element in the hash table using linear probing, 
- *  returns the closest empty location to the home index if element is not found
+ *  Description: Returns the element after cursor cp in SET sp and moves the cursor
+ *  to it, or returns NULL once the walk is over
+ */
+char *setNext(SET *sp, CURSOR *cp) {
+	assert((sp!=NULL) && (cp!=NULL));
+	while(++cp->index < sp->length) {
+		if(sp->slots[cp->index].data != NULL)
+			return text(sp, cp->index);
+	}
+	cp->index = sp->length;
+	return NULL;
+}
+
+
+/*
+ *  Time Complexity: O(n)
+ *  Description: Calls visit on every element of SET sp, passing arg along
  */
-int search(SET *sp, char *elt, bool *found) {
-	int home = strhash(elt) % (sp->length);
-	int deleted = -1;
-	int index, i;
+void forEachElement(SET *sp, void (*visit)(char *elt, void *arg), void *arg) {
+	assert((sp!=NULL) && (visit!=NULL));
+	int i;
 	for(i = 0; i < sp->length; i++) {
-		index = (home + i) % sp->length;
-		if(sp->flag[index] == 'D') {
-			if(deleted == -1)  /* saves first occurrence of deleted index */
-				deleted = index;
+		if(sp->slots[i].data != NULL)
+			(*visit)(text(sp, i), arg);
+	}
+}
+
+
+/*
+ *  Time Complexity: O(n/t) expected, with t threads
+ *  Description: Creates a set holding the distinct strings among the n in elts using
+ *  nthreads threads.  If lengths is NULL the strings are taken to be null terminated,
+ *  otherwise elts[i] is the lengths[i] bytes starting there.  Keys are split into partitions by the top bits of their hash,
+ *  and each thread deduplicates whole partitions and then places them in the range
+ *  of the final table that their hashes map to, so no key ever needs a lock
+ */
+SET *createSetFromArray(char *elts[], int lengths[], int n, int nthreads) {
+	assert((elts!=NULL) && (n >= 0));
+	BUILD b;
+	int i, j, p, offset;
+	if(n == 0)
+		return createSet(0);
+	b.elts = elts;
+	b.lengths = lengths;
+	b.n = n;
+	b.nthreads = (nthreads < 1) ? 1 : (nthreads > MAX_THREADS) ? MAX_THREADS : nthreads;
+	for(b.partitions = 1; b.partitions < 4*b.nthreads; b.partitions *= 2)
+		;  /* several partitions per thread evens out their sizes */
+	b.bits = 32 - tableShift(b.partitions);
+	b.keys = malloc(sizeof(SLOT)*n);
+	b.sorted = malloc(sizeof(SLOT)*n);
+	b.counts = calloc(b.nthreads*b.partitions, sizeof(int));
+	b.parts = malloc(sizeof(SET*)*b.partitions);
+	b.spill = calloc(b.partitions, sizeof(SLOT*));
+	b.spilled = calloc(b.partitions, sizeof(int));
+	assert(b.keys!=NULL && b.sorted!=NULL && b.counts!=NULL && b.parts!=NULL);
+	assert(b.spill!=NULL && b.spilled!=NULL);
+
+	/* hash every key, counting how many of each thread's keys fall in each partition */
+	run(&b, hashKeys);
+	offset = 0;
+	for(p = 0; p < b.partitions; p++) {
+		for(i = 0; i < b.nthreads; i++) {
+			j = b.counts[i*b.partitions + p];
+			b.counts[i*b.partitions + p] = offset;
+			offset += j;
 		}
-		else if(sp->flag[index] == 'E') {
-			*found = false;  /* element was not found, returns first occurence of empty location */ 
-			if(deleted > -1)
-				return deleted;
-			return index;
+	}
+	run(&b, scatterKeys);
+	free(b.keys);
+	run(&b, dedupKeys);
+	free(b.sorted);
+
+	/* size the final table for the distinct keys and place every partition in it */
+	offset = 0;
+	for(p = 0; p < b.partitions; p++)
+		offset += b.parts[p]->count;
+	b.sp = createSet(offset);
+	b.sp->count = offset;
+	if(b.sp->length >= MIN_LENGTH*b.partitions)
+		run(&b, placeKeys);
+	else {
+		for(p = 0; p < b.partitions; p++) {
+			for(i = 0; i < b.parts[p]->length; i++) {
+				SLOT slot = b.parts[p]->slots[i];
+				if(slot.data != NULL) {
+					slot.hash = rotate(slot.hash, 32 - b.bits);
+					insert(b.sp, home(b.sp, slot.hash), 0, slot);
+				}
+			}
 		}
-		else if(strcmp(sp->data[index], elt) == 0) {
-			*found = true; /* element was found, returns location */
-			return index;
+	}
+
+	/* place what spilled out of each range and take over the partitions' strings */
+	for(p = 0; p < b.partitions; p++) {
+		for(i = 0; i < b.spilled[p]; i++)
+			insert(b.sp, home(b.sp, b.spill[p][i].hash), 0, b.spill[p][i]);
+		free(b.spill[p]);
+		while(b.parts[p]->blocks != NULL) {
+			BLOCK *bp = b.parts[p]->blocks;
+			b.parts[p]->blocks = bp->next;
+			bp->next = b.sp->blocks;
+			b.sp->blocks = bp;
+		}
+		b.sp->live += b.parts[p]->live;
+		b.sp->dead += b.parts[p]->dead;
+		destroySet(b.parts[p]);
+	}
+	free(b.counts);
+	free(b.parts);
+	free(b.spill);
+	free(b.spilled);
+	return b.sp;
+}
+
+
+/*
+ *  Time Complexity: O(n)
+ *  Description: Writes SET sp to the named file as a snapshot that loadSet can map
+ *  back in, returning nonzero on success.  Slots are written as they are, with each
+ *  string's offset in the file in place of its address, so the file does not depend
+ *  on where it is mapped.  It does depend on the hash seed and on the byte order and
+ *  word size of the machine
+ */
+int saveSet(SET *sp, char *name) {
+	assert((sp!=NULL) && (name!=NULL));
+	HEADER header;
+	SLOT slot;
+	FILE *fp;
+	long offset;
+	int i, error;
+	if((fp = fopen(name, "w")) == NULL)
+		return 0;
+	memset(&header, 0, sizeof(HEADER));
+	strcpy(header.magic, MAGIC);
+	header.check = hashBytes(MAGIC, sizeof(header.magic));
+	header.count = sp->count;
+	header.length = sp->length;
+	offset = sizeof(HEADER) + sizeof(SLOT)*sp->length;
+	for(i = 0; i < sp->length; i++) {
+		if(sp->slots[i].data != NULL)
+			offset += sp->slots[i].length + 1;
+	}
+	header.size = offset;
+	fwrite(&header, sizeof(HEADER), 1, fp);
+	offset = sizeof(HEADER) + sizeof(SLOT)*sp->length;
+	for(i = 0; i < sp->length; i++) {
+		slot = sp->slots[i];
+		if(slot.data != NULL) {
+			slot.data = (char *) offset;
+			offset += slot.length + 1;
+		}
+		fwrite(&slot, sizeof(SLOT), 1, fp);
+	}
+	for(i = 0; i < sp->length; i++) {
+		if(sp->slots[i].data != NULL)
+			fwrite(text(sp, i), 1, sp->slots[i].length + 1, fp);
+	}
+	error = ferror(fp);
+	if(fclose(fp) != 0)
+		error = 1;
+	return !error;
+}
+
+
+/*
+ *  Time Complexity: O(n)
+ *  Description: Returns a set mapped read only from the snapshot in the named file,
+ *  or NULL if it cannot be read, was written under another hash seed, or has a slot
+ *  whose string does not lie wholly within the file.  Nothing is allocated per
+ *  element: lookups probe the mapped slots directly, and the slots are copied out
+ *  only when the set is first changed, leaving the strings in the file
+ */
+SET *loadSet(char *name) {
+	assert(name!=NULL);
+	struct stat st;
+	HEADER *hp;
+	void *mapping;
+	int fd;
+	if((fd = open(name, O_RDONLY)) == -1)
+		return NULL;
+	if(fstat(fd, &st) == -1 || st.st_size < sizeof(HEADER)) {
+		close(fd);
+		return NULL;
+	}
+	mapping = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(mapping == MAP_FAILED)
+		return NULL;
+	hp = mapping;
+	if(memcmp(hp->magic, MAGIC, sizeof(hp->magic)) != 0 || hp->check != (unsigned) hashBytes(MAGIC, sizeof(hp->magic))
+			|| hp->size != st.st_size || hp->length < MIN_LENGTH
+			|| (hp->length & (hp->length - 1)) != 0 || hp->count > hp->length
+			|| sizeof(HEADER) + sizeof(SLOT)*(size_t) hp->length > st.st_size) {
+		munmap(mapping, st.st_size);
+		return NULL;
+	}
+	if(!checkSlots(mapping, st.st_size)) {
+		munmap(mapping, st.st_size);
+		return NULL;
+	}
+	SET *sp = malloc(sizeof(SET));
+	assert(sp!=NULL);
+	sp->slots = (SLOT *) ((char *) mapping + sizeof(HEADER));
+	sp->count = hp->count;
+	sp->length = hp->length;
+	sp->shift = tableShift(sp->length);
+	sp->blocks = NULL;
+	sp->live = 0;
+	sp->dead = 0;
+	sp->base = mapping;
+	sp->mapping = mapping;
+	sp->size = st.st_size;
+	sp->filter = NULL;
+	return sp;
+}
+
+
+/*
+ *  Time Complexity: O(n)
+ *  Description: Returns whether every slot of the snapshot mapped at mapping, whose
+ *  header has already been checked, has its string after the slots and within the
+ *  size bytes of the file, and null terminated at its length, and whether there are
+ *  as many as the header counts
+ */
+static bool checkSlots(char *mapping, size_t size) {
+	HEADER *hp = (HEADER *) mapping;
+	SLOT *slots = (SLOT *) (mapping + sizeof(HEADER));
+	size_t start = sizeof(HEADER) + sizeof(SLOT)*(size_t) hp->length;
+	size_t offset;
+	int i, count = 0;
+	for(i = 0; i < hp->length; i++) {
+		if(slots[i].data == NULL)
+			continue;
+		offset = (size_t) slots[i].data;
+		if(slots[i].length < 0 || offset < start || offset >= size
+				|| slots[i].length >= size - offset || mapping[offset + slots[i].length] != '\0')
+			return false;
+		count++;
+	}
+	return count == hp->count;
+}
+
+
+/*
+ *  Time Complexity: O(n) the first time, and O(1) after
+ *  Description: Copies the slots of a set loaded by loadSet out of the read only
+ *  mapping so they can be changed, pointing each at its string in the mapping
+ */
+static void thaw(SET *sp) {
+	SLOT *slots;
+	int i;
+	if(sp->base == NULL)
+		return;
+	slots = malloc(sizeof(SLOT)*sp->length);
+	assert(slots!=NULL);
+	for(i = 0; i < sp->length; i++) {
+		slots[i] = sp->slots[i];
+		if(slots[i].data != NULL)
+			slots[i].data = text(sp, i);
+	}
+	sp->slots = slots;
+	sp->base = NULL;
+}
+
+
+/*
+ *  Time Complexity: O(n)
+ *  Description: Returns the smallest power of two table length that keeps
+ *  n elements at or below half full
+ */
+static int tableLength(int n) {
+	int length = MIN_LENGTH;
+	while(length < 2*n) {
+		assert(length <= INT_MAX/2);
+		length *= 2;
+	}
+	return length;
+}
+
+
+/*
+ *  Time Complexity: O(log n)
+ *  Description: Returns how far a hash is shifted right to give its home slot in a
+ *  table of the given power of two length
+ */
+static int tableShift(int length) {
+	int shift = 32;
+	while(length > 1) {
+		length /= 2;
+		shift--;
+	}
+	return shift;
+}
+
+
+/*
+ *  Time Complexity: O(n)
+ *  Description: Moves every element of SET sp into a new table of the given length,
+ *  placing each by its cached hash without reading the string again
+ */
+static void rehash(SET *sp, int length) {
+	SLOT *slots = sp->slots;
+	int oldLength = sp->length;
+	int i;
+	sp->length = length;
+	sp->shift = tableShift(length);
+	sp->slots = malloc(sizeof(SLOT)*length);
+	assert(sp->slots!=NULL);
+	for(i = 0; i < length; i++)
+		sp->slots[i].data = NULL;
+	for(i = 0; i < oldLength; i++) {
+		if(slots[i].data != NULL)
+			insert(sp, home(sp, slots[i].hash), 0, slots[i]);
+	}
+	free(slots);
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1) amortized]
+ *  Description: Adds a copy of elt, whose hash and length are in slot, at index and
+ *  dist as found by search, growing the table first once more than three quarters
+ *  of its slots are full.  Returns the copy
+ */
+static char *add(SET *sp, char *elt, SLOT slot, int index, int dist) {
+	bool found;
+	if(4*(sp->count + 1) > 3*sp->length) {
+		rehash(sp, tableLength(sp->count + 1));
+		index = search(sp, elt, slot.hash, slot.length, &found, &dist);
+	}
+	slot.data = allocate(sp, elt, slot.length);
+	insert(sp, index, dist, slot);
+	sp->count++;
+	if(sp->filter != NULL) {
+		if(bloomFull(sp->filter))
+			buildFilter(sp);
+		else
+			addToBloom(sp->filter, slot.hash);
+	}
+	return slot.data;
+}
+
+
+/*
+ *  Time Complexity: O(n)
+ *  Description: Replaces the filter of SET sp with one built from the cached hashes
+ *  of its elements, with room for as many again before it fills up.  Removals leave
+ *  their hashes in the filter, and this is how they are cleared out
+ */
+static void buildFilter(SET *sp) {
+	int i;
+	if(sp->filter != NULL)
+		destroyBloom(sp->filter);
+	sp->filter = createBloom(2*sp->count);
+	for(i = 0; i < sp->length; i++) {
+		if(sp->slots[i].data != NULL)
+			addToBloom(sp->filter, sp->slots[i].hash);
+	}
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1) amortized]
+ *  Description: Removes the element at index by shifting the rest of its cluster
+ *  back one slot, so no deleted markers are left behind, and shrinks the table
+ *  once fewer than one eighth of its slots are full.  The string's space is
+ *  reclaimed once removed strings take up more block space than present ones
+ */
+static void erase(SET *sp, int index) {
+	sp->live -= sp->slots[index].length + 1;
+	sp->dead += sp->slots[index].length + 1;
+	int next = (index + 1) & (sp->length - 1);
+	/* stops at an empty slot or an element already home */
+	while(sp->slots[next].data != NULL && distance(sp, next) > 0) {
+		sp->slots[index] = sp->slots[next];
+		index = next;
+		next = (next + 1) & (sp->length - 1);
+	}
+	sp->slots[index].data = NULL;
+	sp->count--;
+	if(sp->length > MIN_LENGTH && 8*sp->count < sp->length)
+		rehash(sp, tableLength(sp->count));
+	if(sp->dead > BLOCK_SIZE && sp->dead > sp->live)
+		compact(sp);
+}
+
+
+/*
+ *  Time Complexity: O(n)
+ *  Description: Copies s, of the given length, into the space left in the newest
+ *  block of SET sp, starting a new block when it does not fit
+ */
+static char *allocate(SET *sp, char *s, int length) {
+	BLOCK *bp = sp->blocks;
+	if(bp == NULL || bp->used + length + 1 > bp->size) {
+		int size = (length + 1 > BLOCK_SIZE) ? length + 1 : BLOCK_SIZE;
+		bp = malloc(sizeof(BLOCK) + size);
+		assert(bp!=NULL);
+		bp->next = sp->blocks;
+		bp->used = 0;
+		bp->size = size;
+		sp->blocks = bp;
+	}
+	char *copy = bp->text + bp->used;
+	memcpy(copy, s, length);
+	copy[length] = '\0';
+	bp->used += length + 1;
+	sp->live += length + 1;
+	return copy;
+}
+
+
+/*
+ *  Time Complexity: O(n)
+ *  Description: Copies every present string of SET sp into fresh blocks and frees
+ *  the old ones, reclaiming the space of removed strings
+ */
+static void compact(SET *sp) {
+	BLOCK *old = sp->blocks;
+	BLOCK *bp;
+	int i;
+	sp->blocks = NULL;
+	sp->live = 0;
+	sp->dead = 0;
+	for(i = 0; i < sp->length; i++) {
+		if(sp->slots[i].data != NULL)
+			sp->slots[i].data = allocate(sp, sp->slots[i].data, sp->slots[i].length);
+	}
+	while(old != NULL) {
+		bp = old;
+		old = bp->next;
+		free(bp);
+	}
+}
+
+
+/*
+ *  Time Complexity: O(n/t)
+ *  Description: Runs phase of a build on every thread and waits for them all.  A
+ *  worker for which no thread can be created runs its share here instead
+ */
+static void run(BUILD *bp, void *(*phase)(void *)) {
+	pthread_t threads[MAX_THREADS];
+	WORKER workers[MAX_THREADS];
+	bool started[MAX_THREADS];
+	int i;
+	for(i = 0; i < bp->nthreads; i++) {
+		workers[i].bp = bp;
+		workers[i].id = i;
+		started[i] = pthread_create(&threads[i], NULL, phase, &workers[i]) == 0;
+		if(!started[i])
+			(*phase)(&workers[i]);
+	}
+	for(i = 0; i < bp->nthreads; i++) {
+		if(started[i])
+			pthread_join(threads[i], NULL);
+	}
+}
+
+
+/*
+ *  Time Complexity: O(n/t)
+ *  Description: Build phase hashing one thread's slice of the keys and counting
+ *  how many fall in each partition
+ */
+static void *hashKeys(void *arg) {
+	WORKER *wp = arg;
+	BUILD *bp = wp->bp;
+	int start = (long) bp->n * wp->id / bp->nthreads;
+	int end = (long) bp->n * (wp->id + 1) / bp->nthreads;
+	int *counts = bp->counts + wp->id*bp->partitions;
+	int i;
+	for(i = start; i < end; i++) {
+		assert(bp->elts[i]!=NULL);
+		bp->keys[i].data = bp->elts[i];
+		bp->keys[i].length = (bp->lengths != NULL) ? bp->lengths[i] : strlen(bp->elts[i]);
+		bp->keys[i].hash = hashBytes(bp->elts[i], bp->keys[i].length);
+		counts[bp->bits > 0 ? bp->keys[i].hash >> (32 - bp->bits) : 0]++;
+	}
+	return NULL;
+}
+
+
+/*
+ *  Time Complexity: O(n/t)
+ *  Description: Build phase copying one thread's slice of the keys to where their
+ *  partition starts in the sorted array, past those of earlier threads
+ */
+static void *scatterKeys(void *arg) {
+	WORKER *wp = arg;
+	BUILD *bp = wp->bp;
+	int start = (long) bp->n * wp->id / bp->nthreads;
+	int end = (long) bp->n * (wp->id + 1) / bp->nthreads;
+	int *offsets = bp->counts + wp->id*bp->partitions;
+	int i;
+	for(i = start; i < end; i++)
+		bp->sorted[offsets[bp->bits > 0 ? bp->keys[i].hash >> (32 - bp->bits) : 0]++] = bp->keys[i];
+	return NULL;
+}
+
+
+/*
+ *  Time Complexity: O(n/t) expected
+ *  Description: Build phase adding the keys of every partition this thread owns
+ *  to a set of the partition's own, which drops the duplicates
+ */
+static void *dedupKeys(void *arg) {
+	WORKER *wp = arg;
+	BUILD *bp = wp->bp;
+	bool found;
+	SLOT slot;
+	int p, i, index, dist, start, end;
+	for(p = wp->id; p < bp->partitions; p += bp->nthreads) {
+		/* after scattering, counts holds where each slice's part of the partition ends */
+		start = (p == 0) ? 0 : bp->counts[(bp->nthreads - 1)*bp->partitions + p - 1];
+		end = bp->counts[(bp->nthreads - 1)*bp->partitions + p];
+		bp->parts[p] = createSet((end - start)/4);
+		for(i = start; i < end; i++) {
+			slot = bp->sorted[i];
+			slot.hash = rotate(slot.hash, bp->bits);
+			index = search(bp->parts[p], slot.data, slot.hash, slot.length, &found, &dist);
+			if(!found)
+				add(bp->parts[p], slot.data, slot, index, dist);
 		}
 	}
-	*found = false; /* element not found, returns first occurence of deleted location */
-	return deleted;
+	return NULL;
 }
 
 
+/*
+ *  Time Complexity: O(n/t) expected
+ *  Description: Build phase placing the distinct keys of every partition this thread
+ *  owns in the final table.  All of a partition's keys have their home in its own
+ *  range, so threads never write the same slots, and whatever is pushed past the end
+ *  of the range is spilled to be placed afterwards
+ */
+static void *placeKeys(void *arg) {
+	WORKER *wp = arg;
+	BUILD *bp = wp->bp;
+	SET *part;
+	SLOT slot;
+	int p, i, limit;
+	int range = bp->sp->length / bp->partitions;
+	for(p = wp->id; p < bp->partitions; p += bp->nthreads) {
+		part = bp->parts[p];
+		limit = 0;
+		for(i = 0; i < part->length; i++) {
+			slot = part->slots[i];
+			slot.hash = rotate(slot.hash, 32 - bp->bits);
+			if(slot.data != NULL && !insertRange(bp->sp, home(bp->sp, slot.hash), (p + 1)*range, &slot)) {
+				if(bp->spilled[p] == limit) {
+					limit = (limit == 0) ? MIN_LENGTH : 2*limit;
+					bp->spill[p] = realloc(bp->spill[p], sizeof(SLOT)*limit);
+					assert(bp->spill[p]!=NULL);
+				}
+				bp->spill[p][bp->spilled[p]++] = slot;
+			}
+		}
+	}
+	return NULL;
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1)]
+ *  Description: Places *slot in its home range of SET sp as insert does, but never
+ *  past end.  Returns false if an element was pushed out of the range, leaving it
+ *  in *slot
+ */
+static bool insertRange(SET *sp, int index, int end, SLOT *slot) {
+	SLOT temp;
+	int dist = 0;
+	int tempDist;
+	while(index < end && sp->slots[index].data != NULL) {
+		tempDist = distance(sp, index);
+		if(tempDist < dist) {
+			temp = sp->slots[index];
+			sp->slots[index] = *slot;
+			*slot = temp;
+			dist = tempDist;
+		}
+		index++;
+		dist++;
+	}
+	if(index == end)
+		return false;
+	sp->slots[index] = *slot;
+	return true;
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1)]
+ *  Description: Places slot at index, which is dist slots from its home, using Robin
+ *  Hood hashing: whenever the element being placed is farther from home than the
+ *  one occupying a slot, they trade places and the displaced element moves on
+ */
+static void insert(SET *sp, int index, int dist, SLOT slot) {
+	SLOT temp;
+	int tempDist;
+	while(sp->slots[index].data != NULL) {
+		tempDist = distance(sp, index);
+		if(tempDist < dist) {
+			temp = sp->slots[index];
+			sp->slots[index] = slot;
+			slot = temp;
+			dist = tempDist;
+		}
+		index = (index + 1) & (sp->length - 1);
+		dist++;
+	}
+	sp->slots[index] = slot;
+}
+
+
+/*
+ *  Time Complexity: O(n) [expected O(1)]
+ *  Description: Locates a specific element in the hash table using linear probing,
+ *  stopping early once a slot holds an element closer to its home than elt would be.
+ *  Slots are only compared with memcmp when their cached hash and length match,
+ *  so elt need not be null terminated.
+ *  If the element is not found, returns the slot where it belongs and its distance
+ *  from home through dist
+ */
+static int search(SET *sp, char *elt, unsigned hash, int length, bool *found, int *dist) {
+	int index = home(sp, hash);
+	int i = 0;
+	while(sp->slots[index].data != NULL && distance(sp, index) >= i) {
+		if(sp->slots[index].hash == hash && sp->slots[index].length == length
+				&& memcmp(text(sp, index), elt, length) == 0) {
+			*found = true; /* element was found, returns location */
+			*dist = i;
+			return index;
+		}
+		index = (index + 1) & (sp->length - 1);
+		i++;
+	}
+	*found = false; /* element not found, returns the slot it would be placed in */
+	*dist = i;
+	return index;
+}
@@ -0,0 +1,180 @@
+/*
+ * Description: Tokenizer for files of white space separated words.  The file is
+ * mapped with mmap, or read whole if it cannot be mapped, and word boundaries are
+ * found sixteen bytes at a time with SSE2: a byte is white space if it is a blank
+ * or one of the control characters from tab to carriage return, which is what
+ * isspace accepts in the C locale.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "token.h"
+
+#define GROUP 16
+#define space(c) ((c) == ' ' || (unsigned char) ((c) - '\t') <= '\r' - '\t')
+
+static unsigned spaces(char *p);
+static char *skip(char *p, char *end, bool white);
+static char *readAll(int fd, long *size);
+
+struct tokens {
+	char *text;
+	char *next;
+	char *end;
+	long size;
+	bool mapped;
+};
+
+
+/*
+ *  Time Complexity: O(n) if the file cannot be mapped, otherwise O(1)
+ *  Description: Opens the named file for tokenizing, or returns NULL if it cannot
+ *  be opened or read
+ */
+TOKENS *openTokens(char *name) {
+	assert(name!=NULL);
+	struct stat st;
+	TOKENS *tp;
+	int fd = open(name, O_RDONLY);
+	if(fd < 0)
+		return NULL;
+	tp = malloc(sizeof(TOKENS));
+	assert(tp!=NULL);
+	tp->mapped = false;
+	tp->text = NULL;
+	if(fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+		tp->size = st.st_size;
+		tp->text = mmap(NULL, tp->size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(tp->text != MAP_FAILED) {
+			tp->mapped = true;
+			madvise(tp->text, tp->size, MADV_SEQUENTIAL);
+		}
+		else
+			tp->text = NULL;
+	}
+	if(!tp->mapped && (tp->text = readAll(fd, &tp->size)) == NULL) {
+		close(fd);
+		free(tp);
+		return NULL;
+	}
+	close(fd);
+	tp->next = tp->text;
+	tp->end = tp->text + tp->size;
+	return tp;
+}
+
+
+/*
+ *  Time Complexity: O(n) in the length of the word and the space before it
+ *  Description: Stores the next word of TOKENS tp and its length through word and
+ *  length, returning false once there are no words left
+ */
+bool nextToken(TOKENS *tp, char **word, int *length) {
+	assert((tp!=NULL) && (word!=NULL) && (length!=NULL));
+	char *p = skip(tp->next, tp->end, true);
+	if(p == tp->end) {
+		tp->next = p;
+		return false;
+	}
+	tp->next = skip(p, tp->end, false);
+	*word = p;
+	*length = tp->next - p;
+	return true;
+}
+
+
+/*
+ *  Time Complexity: O(1)
+ *  Description: Unmaps or frees the text of TOKENS tp, after which none of the
+ *  words it returned may be used
+ */
+void closeTokens(TOKENS *tp) {
+	assert(tp!=NULL);
+	if(tp->mapped)
+		munmap(tp->text, tp->size);
+	else
+		free(tp->text);
+	free(tp);
+}
+
+
+/*
+ *  Time Complexity: O(1)
+ *  Description: Returns a bit mask of the white space bytes among the sixteen
+ *  starting at p
+ */
+static unsigned spaces(char *p) {
+#ifdef __SSE2__
+	__m128i group = _mm_loadu_si128((__m128i *) p);
+	__m128i controls = _mm_sub_epi8(group, _mm_set1_epi8('\t'));
+	/* tab through carriage return are the bytes whose offset from tab is at most 4 */
+	__m128i low = _mm_cmpeq_epi8(_mm_min_epu8(controls, _mm_set1_epi8('\r' - '\t')), controls);
+	__m128i blank = _mm_cmpeq_epi8(group, _mm_set1_epi8(' '));
+	return _mm_movemask_epi8(_mm_or_si128(low, blank));
+#else
+	unsigned mask = 0;
+	int i;
+	for(i = 0; i < GROUP; i++) {
+		if(space(p[i]))
+			mask |= 1u << i;
+	}
+	return mask;
+#endif
+}
+
+
+/*
+ *  Time Complexity: O(n)
+ *  Description: Returns the first byte from p up to end that is not white space if
+ *  white is true, or that is white space if white is false, or end if there is none
+ */
+static char *skip(char *p, char *end, bool white) {
+	unsigned mask;
+	while(end - p >= GROUP) {
+		mask = spaces(p);
+		if(white)
+			mask = ~mask & 0xFFFF;
+		if(mask != 0)
+			return p + __builtin_ctz(mask);
+		p += GROUP;
+	}
+	while(p < end && space(*p) == white)
+		p++;
+	return p;
+}
+
+
+/*
+ *  Time Complexity: O(n)
+ *  Description: Reads everything left in the file open on fd, for files that
+ *  cannot be mapped such as pipes, storing its length through size
+ */
+static char *readAll(int fd, long *size) {
+	long length = 0;
+	long max = BUFSIZ;
+	ssize_t count;
+	char *text = malloc(max);
+	assert(text!=NULL);
+	while((count = read(fd, text + length, max - length)) > 0) {
+		length += count;
+		if(length == max) {
+			text = realloc(text, max *= 2);
+			assert(text!=NULL);
+		}
+	}
+	if(count < 0) {
+		free(text);
+		return NULL;
+	}
+	*size = length;
+	return text;
+}
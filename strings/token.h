@@ -0,0 +1,26 @@
+/*
+ * File:        token.h
+ *
+ * Description: This file contains the public function and type
+ *              declarations for a tokenizer that splits a file into words
+ *              separated by white space, as fscanf's %s conversion does.
+ *              The file is mapped into memory and each word is returned
+ *              as a pointer into the mapping and a length, so words are
+ *              never copied and are not null terminated.  They stay valid
+ *              until the tokenizer is closed.
+ */
+
+# ifndef TOKEN_H
+# define TOKEN_H
+
+# include <stdbool.h>
+
+typedef struct tokens TOKENS;
+
+TOKENS *openTokens(char *name);
+
+bool nextToken(TOKENS *tp, char **word, int *length);
+
+void closeTokens(TOKENS *tp);
+
+# endif /* TOKEN_H */
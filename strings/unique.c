@@ -11,19 +11,136 @@
  *              are inserted into the set and the counts of total words and
  *              total words in the set are printed.  If the second file is
  *              given then all words in the second file are deleted from
- *              the set and the count printed.
+ *              the set and the count printed.  With -f, a Bloom filter
+ *              is put in front of the set before the second file is read,
+ *              so words that were never in the set are passed over
+ *              without probing its table.
+ *
+ *              With -e, no set is built.  The words of every file named
+ *              are instead added to a HyperLogLog sketch of a few kilobytes,
+ *              one per file and each on its own thread, and the sketches
+ *              are merged to estimate how many distinct words there are
+ *              in all the files together.
  */
 
 # include <stdio.h>
 # include <stdlib.h>
 # include <string.h>
 # include <stdbool.h>
+# include <pthread.h>
 # include "set.h"
+# include "hll.h"
+# include "token.h"
+
+
+/* The words of the first file are added to the set all at once by this many
+   threads. */
+
+# define THREADS 4
+
+
+/* A sketch of 2^PRECISION one byte registers estimates with a standard error of
+   about 1.6%. */
+
+# define PRECISION 12
+
+struct sketch {
+    char *name;
+    HLL *hp;
+    int words;
+    bool opened;
+};
+
+
+/*
+ * Function:    sketchFile
+ *
+ * Description: Thread body: add every word of a file to its own sketch.
+ */
+
+static void *sketchFile(void *arg)
+{
+    struct sketch *sp = arg;
+    TOKENS *tp;
+    char *word;
+    int length;
+
 
+    if ((tp = openTokens(sp->name)) == NULL)
+	return NULL;
 
-/* This is sufficient for the test cases in /scratch/coen12. */
+    sp->opened = true;
 
-# define MAX_SIZE 18000
+    while (nextToken(tp, &word, &length)) {
+	addToHLL(sp->hp, word, length);
+	sp->words ++;
+    }
+
+    closeTokens(tp);
+    return NULL;
+}
+
+
+/*
+ * Function:    estimate
+ *
+ * Description: Sketch each of n files on a thread of its own, merge the
+ *              sketches, and print the total number of words and the
+ *              estimated number of distinct words.
+ */
+
+static void estimate(char *program, char *names[], int n)
+{
+    struct sketch *sketches;
+    pthread_t *threads;
+    int i, words;
+
+
+    sketches = malloc(sizeof(struct sketch) * n);
+    threads = malloc(sizeof(pthread_t) * n);
+
+    if (sketches == NULL || threads == NULL) {
+	fprintf(stderr, "%s: out of memory\n", program);
+	exit(EXIT_FAILURE);
+    }
+
+    for (i = 0; i < n; i ++) {
+	sketches[i].name = names[i];
+	sketches[i].hp = createHLL(PRECISION);
+	sketches[i].words = 0;
+	sketches[i].opened = false;
+
+	if (pthread_create(&threads[i], NULL, sketchFile, &sketches[i]) != 0) {
+	    fprintf(stderr, "%s: cannot create thread\n", program);
+	    exit(EXIT_FAILURE);
+	}
+    }
+
+    words = 0;
+
+    for (i = 0; i < n; i ++) {
+	pthread_join(threads[i], NULL);
+
+	if (!sketches[i].opened) {
+	    fprintf(stderr, "%s: cannot open %s\n", program, names[i]);
+	    exit(EXIT_FAILURE);
+	}
+
+	words += sketches[i].words;
+
+	if (i > 0) {
+	    mergeHLL(sketches[0].hp, sketches[i].hp);
+	    destroyHLL(sketches[i].hp);
+	}
+    }
+
+    printf("%d total words\n", words);
+    printf("about %.0f distinct words\n", estimateHLL(sketches[0].hp));
+
+    destroyHLL(sketches[0].hp);
+    free(sketches);
+    free(threads);
+}
 
 
 /*
@@ -34,17 +151,27 @@
 
 int main(int argc, char *argv[])
 {
-    FILE *fp;
-    char buffer[BUFSIZ], **elts;
+    TOKENS *tp;
+    char *word, **elts;
     SET *unique;
-    int i, words;
-    bool lflag = false;
+    CURSOR cursor;
+    int i, words, length, max, *lengths;
+    bool lflag = false, fflag = false;
 
 
-    /* Check usage and open the first file. */
+    /* Check usage and read the first file. */
+
+    if (argc > 2 && strcmp(argv[1], "-e") == 0) {
+	estimate(argv[0], argv + 2, argc - 2);
+	exit(EXIT_SUCCESS);
+    }
+
+    while (argc > 1 && (strcmp(argv[1], "-l") == 0 || strcmp(argv[1], "-f") == 0)) {
+	if (argv[1][1] == 'l')
+	    lflag = true;
+	else
+	    fflag = true;
 
-    if (argc > 1 && strcmp(argv[1], "-l") == 0) {
-	lflag = true;
 	argc --;
 
 	for (i = 1; i < argc; i ++)
@@ -52,27 +179,43 @@ int main(int argc, char *argv[])
     }
 
     if (argc == 1 || argc > 3) {
-        fprintf(stderr, "usage: %s [-l] file1 [file2]\n", argv[0]);
+        fprintf(stderr, "usage: %s [-l] [-f] file1 [file2] | -e file...\n", argv[0]);
         exit(EXIT_FAILURE);
     }
 
-    if ((fp = fopen(argv[1], "r")) == NULL) {
+    if ((tp = openTokens(argv[1])) == NULL) {
         fprintf(stderr, "%s: cannot open %s\n", argv[0], argv[1]);
         exit(EXIT_FAILURE);
     }
 
 
-    /* Insert all words into the set. */
+    /* Insert all words into the set, which copies them out of the file. */
 
     words = 0;
-    unique = createSet(MAX_SIZE);
+    max = 1024;
+    elts = malloc(sizeof(char *) * max);
+    lengths = malloc(sizeof(int) * max);
+
+    while (nextToken(tp, &word, &length)) {
+        if (words == max) {
+            max *= 2;
+            elts = realloc(elts, sizeof(char *) * max);
+            lengths = realloc(lengths, sizeof(int) * max);
+        }
 
-    while (fscanf(fp, "%s", buffer) == 1) {
-        words ++;
-        addElement(unique, buffer);
+        if (elts == NULL || lengths == NULL) {
+            fprintf(stderr, "%s: out of memory\n", argv[0]);
+            exit(EXIT_FAILURE);
+        }
+
+        elts[words] = word;
+        lengths[words ++] = length;
     }
 
-    fclose(fp);
+    unique = createSetFromArray(elts, lengths, words, THREADS);
+    closeTokens(tp);
+    free(elts);
+    free(lengths);
 
     if (!lflag) {
 	printf("%d total words\n", words);
@@ -83,7 +226,7 @@ int main(int argc, char *argv[])
     /* Try to open the second file. */
 
     if (argc == 3) {
-        if ((fp = fopen(argv[2], "r")) == NULL) {
+        if ((tp = openTokens(argv[2])) == NULL) {
             fprintf(stderr, "%s: cannot open %s\n", argv[0], argv[2]);
             exit(EXIT_FAILURE);
         }
@@ -91,10 +234,13 @@ int main(int argc, char *argv[])
 
         /* Delete all words in the second file. */
 
-        while (fscanf(fp, "%s", buffer) == 1)
-            removeElement(unique, buffer);
+	if (fflag)
+	    setFilter(unique, true);
 
-	fclose(fp);
+        while (nextToken(tp, &word, &length))
+            removeBytes(unique, word, length);
+
+	closeTokens(tp);
 
 	if (!lflag)
 	    printf("%d remaining words\n", numElements(unique));
@@ -104,12 +250,9 @@ int main(int argc, char *argv[])
     /* Print the list of words if desired. */
 
     if (lflag) {
-	elts = getElements(unique);
-
-	for (i = 0; i < numElements(unique); i ++)
-	    printf("%s\n", elts[i]);
-
-	free(elts);
+	for (word = setBegin(unique, &cursor); word != NULL;
+		word = setNext(unique, &cursor))
+	    printf("%s\n", word);
     }
 
     destroySet(unique);